@@ -6,7 +6,9 @@
 #endif
 
 #include <filesystem>
+#include <mutex>
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
 #include <vk_lib.h>
@@ -22,6 +24,36 @@ struct Vertex {
     float tex_coord[2][2]{};
 };
 
+// layouts vertices can be uploaded in. test/shaders/common.glsl has the matching decode functions
+enum class VertexFormat {
+    // Vertex, 80 bytes
+    full,
+    // PackedVertex, 32 bytes
+    packed,
+    // QuantizedVertex, 28 bytes
+    quantized,
+};
+
+// normal and tangent are octahedral encoded as two snorm16 values, with the bitangent sign of the tangent in the lowest bit of its second
+// value. color is unorm8x4 and the texture coordinates are half floats
+struct PackedVertex {
+    float    position[3]{};
+    uint32_t normal{};
+    uint32_t tangent{};
+    uint32_t color{};
+    uint16_t tex_coord[2][2]{};
+};
+
+// PackedVertex with its position stored as unorm16 across the primitive's bounds, from origin - extent to origin + extent
+struct QuantizedVertex {
+    uint16_t position[3]{};
+    uint16_t padding{};
+    uint32_t normal{};
+    uint32_t tangent{};
+    uint32_t color{};
+    uint16_t tex_coord[2][2]{};
+};
+
 struct GltfTexture {
     std::optional<uint32_t> image_index;
     std::optional<uint32_t> sampler_index;
@@ -66,15 +98,65 @@ struct GltfMaterial {
     GltfAlphaMode alpha_mode{};
 };
 
+// material slots an image can be referenced from. GltfImage::usage is a bitmask of them
+enum TextureUsage : uint32_t {
+    texture_usage_base_color          = 1 << 0,
+    texture_usage_emissive            = 1 << 1,
+    texture_usage_normal              = 1 << 2,
+    texture_usage_occlusion           = 1 << 3,
+    texture_usage_metallic_roughness  = 1 << 4,
+    texture_usage_diffuse             = 1 << 5,
+    texture_usage_specular_glossiness = 1 << 6,
+    texture_usage_clearcoat           = 1 << 7,
+    texture_usage_clearcoat_roughness = 1 << 8,
+    texture_usage_clearcoat_normal    = 1 << 9,
+    texture_usage_transmission        = 1 << 10,
+    texture_usage_sheen_color         = 1 << 11,
+    texture_usage_sheen_roughness     = 1 << 12,
+    texture_usage_specular            = 1 << 13,
+    texture_usage_specular_color      = 1 << 14,
+    texture_usage_thickness           = 1 << 15,
+};
+
+// gpu format family a texture was transcoded to, or a ktx2 source already is in. picked per image from the formats the device can sample, in
+// order of smallest size
+enum class TextureTarget {
+    bc7,
+    bc5,
+    bc4,
+    astc_4x4,
+    etc2_rgba,
+    eac_rg11,
+    eac_r11,
+    // uncompressed fallback every device supports
+    rgba8,
+    // the own format of a ktx2 source that none of the above describe, like bc1, bc3, bc6h or float formats. GltfImage::image_format holds it
+    native,
+};
+
 struct GltfImage {
-    VkImage           image{};
-    VkImageView       image_view{};
-    VkFormat          image_format{};
-    VkImageLayout     layout{};
-    VkExtent3D        extent{};
-    uint32_t          mip_levels{1};
-    VmaAllocation     allocation{};
-    VmaAllocationInfo allocation_info{};
+    VkImage       image{};
+    VkImageView   image_view{};
+    VkFormat      image_format{};
+    VkImageLayout layout{};
+    VkExtent3D    extent{};
+    uint32_t      mip_levels{1};
+    TextureTarget target{};
+    // bitmask of TextureUsage for every material slot the image is referenced from. 0 when no material uses it
+    uint32_t usage{};
+    // top mip levels of the source that were dropped to fit the texture budget or max dimensions. the image can be reloaded with more detail
+    // once memory frees up
+    uint32_t lod_bias{};
+    // false while a streamed image only holds the tail of its mip chain. lod_bias then also counts the levels that are still streaming in
+    bool fully_resident{true};
+    // key the image is registered under in LoaderContext::shared_images, where loads of identical images find it. 0 when the asset owns the
+    // image alone
+    uint64_t share_key{};
+    // swizzle image_view was created with. images read through only one or two channels are stored with just those channels, and the swizzle
+    // moves them back to where the material slots read them. normal maps only keep x and y, so z has to be rebuilt from them
+    VkComponentMapping components{};
+    VmaAllocation      allocation{};
+    VmaAllocationInfo  allocation_info{};
 };
 
 struct GltfBuffer {
@@ -95,9 +177,23 @@ struct GltfPrimitive {
     VkIndexType               index_type{VK_INDEX_TYPE_UINT16};
     uint32_t                  index_count{};
     GltfBuffer                vertex_buffer{};
+    uint32_t                  vertex_count{};
     std::optional<uint32_t>   material{};
     VkPrimitiveTopology       topology{VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST};
     Bounds                    bounds{};
+    VertexFormat              vertex_format{VertexFormat::full};
+
+    // only set when the primitive was packed into the loader context's geometry arenas (see LoadOptions::pack_geometry). packed primitives
+    // own no buffers. their uint32 indices start at first_index in the arena buffer, and their vertices start at vertex_offset vertices from
+    // the arena's device address
+    std::optional<uint32_t> geometry_arena{};
+    uint32_t                first_index{};
+    int32_t                 vertex_offset{};
+
+    // only set with LoadOptions::split_positions. positions are read from position_address with the same vertex index as the vertex buffer,
+    // vertex_offset included. unpacked primitives own position_buffer, packed ones keep their positions in the same arena as their vertices
+    std::optional<GltfBuffer> position_buffer{};
+    VkDeviceAddress           position_address{};
 };
 
 struct GltfMesh {
@@ -128,26 +224,262 @@ struct GltfLight {
     float         intensity{1};
 };
 
+struct TextureStreamer;
+
+// counters collected while loading an asset
+struct LoadStats {
+    uint32_t queue_submits{};
+    uint64_t texture_bytes_uploaded{};
+    uint64_t geometry_bytes_uploaded{};
+};
+
 struct GltfAsset {
     std::vector<GltfScene>    scenes{};
     std::vector<GltfNode>     nodes{};
     std::vector<GltfMesh>     meshes{};
     std::vector<GltfMaterial> materials{};
     std::vector<GltfTexture>  textures{};
-    std::vector<GltfImage>    images{};
-    std::vector<VkSampler>    samplers{};
+    // images only used as the fallback of KHR_texture_basisu textures are not loaded, and left empty
+    std::vector<GltfImage> images{};
+    // indices into LoaderContext::samplers
+    std::vector<uint32_t> samplers{};
 
     // EXTENSIONS
     std::vector<GltfLight> lights{};
+
+    LoadStats load_stats{};
+
+    // set when textures were loaded with LoadOptions::stream_textures, until stop_texture_streaming frees it
+    TextureStreamer* texture_streamer{};
+};
+
+// filter used to downsample each mip level from the one above it
+enum class MipFilter {
+    // averages 2x2 texels. cheapest, but slightly blurry
+    box,
+    // kaiser windowed sinc. keeps smaller mips sharper
+    kaiser,
+};
+
+enum class BasisCodec {
+    // small and fast to encode, at a lower quality
+    etc1s,
+    // high quality, but slow to encode and large unless rdo and zstd are used
+    uastc,
+};
+
+// basis encoder settings for images encoded on cold loads. they are part of the cache key, so changing them re-encodes the affected images
+struct EncoderProfile {
+    BasisCodec codec{BasisCodec::uastc};
+    // etc1s only. 0 to 5, higher is slower but smaller
+    uint32_t etc1s_compression_level{2};
+    // etc1s only. 1 to 255, higher is better quality but larger
+    uint32_t etc1s_quality_level{128};
+    // uastc only. 0 (fastest) to 4 (slowest, best quality)
+    uint32_t uastc_quality_level{2};
+    // uastc only. rate distortion optimization lambda, 0 disables it. higher values trade quality for data that zstd compresses better
+    float uastc_rdo_lambda{0};
+    // uastc only. zstd level source cache entries are supercompressed with, 0 disables it. etc1s is always supercompressed with basis lz
+    uint32_t zstd_level{0};
+};
+
+enum class TextureMode {
+    // basis encode images on cold loads and transcode them to the smallest format the device supports
+    compressed,
+    // upload decoded images as rgba8 without encoding, transcoding or caching them. meant for iterating on assets, as loads are decode bound
+    uncompressed,
 };
 
 struct LoadOptions {
     std::filesystem::path gltf_path{};
     std::filesystem::path cache_dir{};
     bool                  create_mipmaps{false};
+    MipFilter             mip_filter{MipFilter::box};
+    TextureMode           texture_mode{TextureMode::compressed};
+    // device memory the textures of one load may take up. the top mip levels of the largest textures are dropped, and not encoded, until all
+    // textures fit. 0 disables the budget
+    uint64_t texture_budget{0};
+    // use the free space of the device local heaps reported by vmaGetHeapBudgets as the texture budget
+    bool texture_budget_from_heaps{false};
+    // largest width or height kept for color, normal map and data images. larger images drop top mip levels until they fit. 0 means no limit
+    uint32_t max_color_dimension{0};
+    uint32_t max_normal_dimension{0};
+    uint32_t max_data_dimension{0};
+    // TextureMode::uncompressed only. blit mip chains on the gpu after all images are uploaded instead of filtering them with mip_filter
+    bool gpu_mipmaps{false};
+    // TextureMode::compressed only. load_gltf uploads only the tail of each mip chain, from the first level that fits in
+    // streaming_tail_dimension, and returns while the full chains keep encoding in the background. poll_texture_streaming uploads them
+    bool     stream_textures{false};
+    uint32_t streaming_tail_dimension{128};
+    // bytes of full chains one poll_texture_streaming call records at most. at least one texture is recorded per call. 0 means no limit
+    uint64_t streaming_upload_budget{32ull * 1024 * 1024};
+    // threads shared by image decoding and the basis encoder. 0 uses every hardware thread
+    uint32_t       thread_count{0};
+    EncoderProfile encoder_profile{};
+    // override encoder_profile for images used as colors, as normal maps or as other data
+    std::optional<EncoderProfile> color_encoder_profile{};
+    std::optional<EncoderProfile> normal_encoder_profile{};
+    std::optional<EncoderProfile> data_encoder_profile{};
+    // sub-allocate the vertices and indices of every primitive from the loader context's geometry arenas instead of creating buffers per
+    // primitive. indices are widened to uint32 so an arena can be bound once for all of its draws
+    bool pack_geometry{false};
+    // smaller vertex layouts trade precision for memory and fetch bandwidth. half float texture coordinates keep about 11 bits of precision
+    // in [0, 1], and quantized positions divide the primitive's bounds into 65536 steps per axis
+    VertexFormat vertex_format{VertexFormat::full};
+    // also upload a tightly packed stream of only positions for depth and shadow passes. positions stay in the vertex stream as well, so
+    // shading passes are unchanged. the stream holds float3 positions, or the unorm16x3 positions and padding of QuantizedVertex
+    bool split_positions{false};
+    // load only the given scene and the nodes, meshes, materials, textures, images, samplers and lights it references. kept resources are
+    // renumbered densely, so asset indices no longer match the file
+    std::optional<uint32_t> scene_index{};
+    // like scene_index, but for the subtrees of these nodes, which become the roots of a single scene. takes precedence over scene_index
+    std::vector<uint32_t> node_filter{};
 };
 
-[[nodiscard]] GltfAsset load_gltf(const LoadOptions* load_options, VmaAllocator allocator, VkDevice device, VkCommandPool command_pool,
-                                  VkQueue queue);
+struct StagingRing;
+
+constexpr uint64_t default_staging_ring_size   = 64ull * 1024 * 1024;
+constexpr uint64_t default_geometry_arena_size = 256ull * 1024 * 1024;
+
+// device buffer that packed primitives sub-allocate both their vertices and indices from. vertex data is placed at multiples of
+// the vertex size of its primitive, so it can be addressed with a vertex offset from the buffer's device address
+struct GeometryArena {
+    GltfBuffer buffer{};
+    uint64_t   size{};
+    uint64_t   used{};
+};
+
+// block compressed formats the device can sample from optimally tiled images. color formats count as supported only when both their unorm
+// and srgb variants are
+struct TextureFormatSupport {
+    bool bc7{};
+    bool bc5{};
+    bool bc4{};
+    bool astc_4x4{};
+    bool etc2_rgba{};
+    bool eac_rg11{};
+    bool eac_r11{};
+};
+
+// an image loaded once for every asset that uses it. destroyed by unload_gltf when the last image index referencing it is unloaded
+struct SharedImage {
+    GltfImage image{};
+    uint32_t  ref_count{};
+};
+
+// a sampler shared by every asset that needs one with the same create info
+struct CachedSampler {
+    VkSampler           sampler{};
+    VkSamplerCreateInfo create_info{};
+    // the slot is reused by the next new sampler once this drops to 0
+    uint32_t ref_count{};
+};
+
+// vulkan handles and upload resources shared across loads. create it once and reuse it for every asset so the staging ring is not reallocated
+struct LoaderContext {
+    VmaAllocator  allocator{};
+    VkDevice      device{};
+    VkCommandPool command_pool{};
+    VkQueue       queue{};
+    // locked around every submit to queue when set. asynchronous loads submit from their own thread, so unless nothing else submits to queue
+    // it must be set, and the caller's own submits and presents must lock it too
+    std::mutex* queue_mutex{};
+    // queried once from the allocator's physical device when the context is created. textures are transcoded to the smallest supported format
+    TextureFormatSupport format_support{};
+    // fixed size host visible buffer every upload is streamed through. larger uploads are split into chunks
+    StagingRing* staging_ring{};
+    // arenas are shared by every asset loaded with LoadOptions::pack_geometry, and live until the context is destroyed
+    uint64_t                   geometry_arena_size{default_geometry_arena_size};
+    std::vector<GeometryArena> geometry_arenas{};
+    // fully resident images of loaded assets, keyed by a hash of their source bytes and everything that affects how they are loaded. loads of
+    // the same images reuse them instead of decoding, encoding and allocating them again
+    std::unordered_map<uint64_t, SharedImage> shared_images{};
+    // applied to every sampler created from here on. anisotropy is clamped to the device limit, and values up to 1 disable it
+    float max_sampler_anisotropy{16};
+    float sampler_lod_bias{0};
+    // queried once when the context is created
+    float device_max_sampler_anisotropy{};
+    // samplers of loaded assets, deduplicated by their create info. GltfAsset::samplers index into it, so released slots are left in place
+    std::vector<CachedSampler> samplers{};
+};
+
+[[nodiscard]] LoaderContext loader_context_create(VmaAllocator allocator, VkDevice device, VkCommandPool command_pool, VkQueue queue,
+                                                  uint64_t staging_ring_size = default_staging_ring_size, std::mutex* queue_mutex = nullptr);
+
+// waits for all uploads still in flight, then frees the staging ring, the geometry arenas and the samplers
+void loader_context_destroy(LoaderContext* loader_context);
+
+// load an asset through loader_context, which owns its samplers, shared images, packed geometry and streamed textures. the context must
+// outlive the asset, so unload the asset before destroying the context.
+// breaking change: the overload load_gltf(load_options, allocator, device, command_pool, queue) that created a temporary context was removed,
+// since the asset's samplers would be destroyed along with that context. create one context with loader_context_create, load every asset
+// through it, and destroy it with loader_context_destroy once they are unloaded
+[[nodiscard]] GltfAsset load_gltf(const LoadOptions* load_options, LoaderContext* loader_context);
+
+enum class LoadStage {
+    parsing,
+    images,
+    meshes,
+    // waiting for the last uploads to complete
+    uploading,
+    finished,
+    cancelled,
+};
+
+struct LoadProgress {
+    LoadStage stage{};
+    uint32_t  images_loaded{};
+    uint32_t  image_count{};
+    uint32_t  meshes_loaded{};
+    uint32_t  mesh_count{};
+    // texture and geometry bytes copied into staging memory so far
+    uint64_t bytes_uploaded{};
+};
+
+struct AsyncLoad;
+
+// start loading an asset on a library owned thread, and return right away. the load records its uploads into a command pool and staging ring
+// of its own, created for queue_family_index, so the loader context's command pool is never touched from another thread. images the load
+// finds in LoaderContext::shared_images are not reused, but the images it loads are shared with later loads
+[[nodiscard]] AsyncLoad* load_gltf_async(const LoadOptions* load_options, LoaderContext* loader_context, uint32_t queue_family_index);
+
+[[nodiscard]] LoadProgress get_load_progress(const AsyncLoad* async_load);
+
+[[nodiscard]] bool is_load_finished(const AsyncLoad* async_load);
+
+// ask the load to stop at the next image or mesh. everything it created so far is freed before it finishes
+void cancel_load(AsyncLoad* async_load);
+
+// wait for the load to finish and free it. the asset's samplers, shared images and packed geometry are moved into loader_context, which must
+// be the context the load was started with. returns nothing when the load was cancelled
+[[nodiscard]] std::optional<GltfAsset> finish_load(AsyncLoad* async_load, LoaderContext* loader_context);
+
+// an image whose full mip chain has replaced its streamed tail in GltfAsset::images
+struct TextureUpgrade {
+    uint32_t image_index{};
+    // the tail image that was replaced. frames in flight may still sample it, so the caller destroys its view and image once they complete.
+    // duplicate images of an asset share one GltfImage and are upgraded together, and only the first of their upgrades holds the tail image
+    GltfImage retired_image{};
+};
+
+// record the uploads of full chains that finished encoding, and swap in the ones whose uploads have completed on the gpu. never waits on the
+// gpu or the encoder, so it can be called once per frame. the upgraded images must be rebound before the next frame uses them
+[[nodiscard]] std::vector<TextureUpgrade> poll_texture_streaming(GltfAsset* gltf_asset, LoaderContext* loader_context);
+
+[[nodiscard]] bool is_texture_streaming_done(const GltfAsset* gltf_asset);
+
+// cancel the encodes that have not started yet, wait for the ones that have and free everything the streamer holds. images keep whatever
+// residency they have. must be called before the asset or the loader context are destroyed, even once streaming is done
+void stop_texture_streaming(GltfAsset* gltf_asset, LoaderContext* loader_context);
+
+// size in bytes of one vertex of vertex_format
+[[nodiscard]] uint32_t get_vertex_size(VertexFormat vertex_format);
+
+// size in bytes of one position in the position stream of vertex_format
+[[nodiscard]] uint32_t get_position_size(VertexFormat vertex_format);
+
+// destroy the images, buffers and samplers of an asset once the gpu is done with it. shared images are destroyed when no other loaded asset
+// uses them anymore. packed primitives stay in the loader context's arenas until the context is destroyed
+void unload_gltf(GltfAsset* gltf_asset, LoaderContext* loader_context);
 
-} // namespace vk_gltf
\ No newline at end of file
+} // namespace vk_gltf
@@ -0,0 +1,392 @@
+#include "accessor_decoder.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(__AVX2__)
+#include <immintrin.h>
+#define VK_GLTF_ACCESSOR_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VK_GLTF_ACCESSOR_NEON
+#endif
+
+namespace vk_gltf {
+
+// elements decoded at once. strided elements are gathered into a tightly packed block first, so the conversions always run over contiguous
+// components
+constexpr uint64_t decode_block_element_count = 256;
+// a vec4 of floats. the block buffers are sized for it, so accessors with more components, like matrices, are rejected
+constexpr uint32_t max_element_size    = 16;
+constexpr uint32_t max_component_count = max_element_size / sizeof(float);
+
+// convert count tightly packed components at src to floats
+using ComponentConverter = void (*)(const uint8_t* src, uint64_t count, float* dst);
+
+template <typename T> [[nodiscard]] static float normalize_component(float value) {
+    constexpr float scale = 1.f / static_cast<float>(std::numeric_limits<T>::max());
+    if constexpr (std::is_signed_v<T>) {
+        return std::max(value * scale, -1.f);
+    } else {
+        return value * scale;
+    }
+}
+
+// converts as many leading components as the simd paths handle and returns their count. the rest are left to the scalar loop
+template <typename T> [[nodiscard]] static uint64_t convert_normalized_simd(const uint8_t*, uint64_t, float*) { return 0; }
+
+#if defined(VK_GLTF_ACCESSOR_SSE)
+// four int32 lanes to normalized floats
+template <typename T> static void store_normalized(__m128i values, float* dst) {
+    const __m128 scale      = _mm_set1_ps(1.f / static_cast<float>(std::numeric_limits<T>::max()));
+    __m128       normalized = _mm_mul_ps(_mm_cvtepi32_ps(values), scale);
+    if constexpr (std::is_signed_v<T>) {
+        normalized = _mm_max_ps(normalized, _mm_set1_ps(-1.f));
+    }
+    _mm_storeu_ps(dst, normalized);
+}
+
+template <> uint64_t convert_normalized_simd<uint8_t>(const uint8_t* src, uint64_t count, float* dst) {
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t      i    = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i low   = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i high  = _mm_unpackhi_epi8(bytes, zero);
+        store_normalized<uint8_t>(_mm_unpacklo_epi16(low, zero), dst + i);
+        store_normalized<uint8_t>(_mm_unpackhi_epi16(low, zero), dst + i + 4);
+        store_normalized<uint8_t>(_mm_unpacklo_epi16(high, zero), dst + i + 8);
+        store_normalized<uint8_t>(_mm_unpackhi_epi16(high, zero), dst + i + 12);
+    }
+    return i;
+}
+
+// sign extension without sse4.1: duplicate each value into the upper half of a wider lane and shift it back down arithmetically
+template <> uint64_t convert_normalized_simd<int8_t>(const uint8_t* src, uint64_t count, float* dst) {
+    uint64_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i low   = _mm_srai_epi16(_mm_unpacklo_epi8(bytes, bytes), 8);
+        const __m128i high  = _mm_srai_epi16(_mm_unpackhi_epi8(bytes, bytes), 8);
+        store_normalized<int8_t>(_mm_srai_epi32(_mm_unpacklo_epi16(low, low), 16), dst + i);
+        store_normalized<int8_t>(_mm_srai_epi32(_mm_unpackhi_epi16(low, low), 16), dst + i + 4);
+        store_normalized<int8_t>(_mm_srai_epi32(_mm_unpacklo_epi16(high, high), 16), dst + i + 8);
+        store_normalized<int8_t>(_mm_srai_epi32(_mm_unpackhi_epi16(high, high), 16), dst + i + 12);
+    }
+    return i;
+}
+
+template <> uint64_t convert_normalized_simd<uint16_t>(const uint8_t* src, uint64_t count, float* dst) {
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t      i    = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i shorts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * sizeof(uint16_t)));
+        store_normalized<uint16_t>(_mm_unpacklo_epi16(shorts, zero), dst + i);
+        store_normalized<uint16_t>(_mm_unpackhi_epi16(shorts, zero), dst + i + 4);
+    }
+    return i;
+}
+
+template <> uint64_t convert_normalized_simd<int16_t>(const uint8_t* src, uint64_t count, float* dst) {
+    uint64_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i shorts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * sizeof(int16_t)));
+        store_normalized<int16_t>(_mm_srai_epi32(_mm_unpacklo_epi16(shorts, shorts), 16), dst + i);
+        store_normalized<int16_t>(_mm_srai_epi32(_mm_unpackhi_epi16(shorts, shorts), 16), dst + i + 4);
+    }
+    return i;
+}
+#elif defined(VK_GLTF_ACCESSOR_NEON)
+template <> uint64_t convert_normalized_simd<uint8_t>(const uint8_t* src, uint64_t count, float* dst) {
+    const float32x4_t scale = vdupq_n_f32(1.f / 255.f);
+    uint64_t          i     = 0;
+    for (; i + 8 <= count; i += 8) {
+        const uint16x8_t shorts = vmovl_u8(vld1_u8(src + i));
+        vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(shorts))), scale));
+        vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(shorts))), scale));
+    }
+    return i;
+}
+
+template <> uint64_t convert_normalized_simd<int8_t>(const uint8_t* src, uint64_t count, float* dst) {
+    const float32x4_t scale   = vdupq_n_f32(1.f / 127.f);
+    const float32x4_t minimum = vdupq_n_f32(-1.f);
+    uint64_t          i       = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t shorts = vmovl_s8(vld1_s8(reinterpret_cast<const int8_t*>(src + i)));
+        vst1q_f32(dst + i, vmaxq_f32(vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(shorts))), scale), minimum));
+        vst1q_f32(dst + i + 4, vmaxq_f32(vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(shorts))), scale), minimum));
+    }
+    return i;
+}
+
+template <> uint64_t convert_normalized_simd<uint16_t>(const uint8_t* src, uint64_t count, float* dst) {
+    const float32x4_t scale = vdupq_n_f32(1.f / 65535.f);
+    uint64_t          i     = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint16x4_t shorts = vld1_u16(reinterpret_cast<const uint16_t*>(src + i * sizeof(uint16_t)));
+        vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_u32(vmovl_u16(shorts)), scale));
+    }
+    return i;
+}
+
+template <> uint64_t convert_normalized_simd<int16_t>(const uint8_t* src, uint64_t count, float* dst) {
+    const float32x4_t scale   = vdupq_n_f32(1.f / 32767.f);
+    const float32x4_t minimum = vdupq_n_f32(-1.f);
+    uint64_t          i       = 0;
+    for (; i + 4 <= count; i += 4) {
+        const int16x4_t shorts = vld1_s16(reinterpret_cast<const int16_t*>(src + i * sizeof(int16_t)));
+        vst1q_f32(dst + i, vmaxq_f32(vmulq_f32(vcvtq_f32_s32(vmovl_s16(shorts)), scale), minimum));
+    }
+    return i;
+}
+#endif
+
+template <typename T> static void convert_components(const uint8_t* src, uint64_t count, float* dst) {
+    for (uint64_t i = 0; i < count; i++) {
+        T value;
+        memcpy(&value, src + i * sizeof(T), sizeof(T));
+        dst[i] = static_cast<float>(value);
+    }
+}
+
+template <typename T> static void convert_normalized_components(const uint8_t* src, uint64_t count, float* dst) {
+    for (uint64_t i = convert_normalized_simd<T>(src, count, dst); i < count; i++) {
+        T value;
+        memcpy(&value, src + i * sizeof(T), sizeof(T));
+        dst[i] = normalize_component<T>(static_cast<float>(value));
+    }
+}
+
+static void copy_floats(const uint8_t* src, uint64_t count, float* dst) { memcpy(dst, src, count * sizeof(float)); }
+
+// gather float elements of N components from one stride to another. the copy size is known at compile time, so each element moves with a
+// couple of vector loads and stores instead of a memcpy call
+template <uint32_t N>
+static void copy_strided_floats(const uint8_t* src, uint64_t src_stride, uint64_t element_count, uint8_t* dst, uint64_t dst_stride) {
+    for (uint64_t e = 0; e < element_count; e++) {
+        memcpy(dst + e * dst_stride, src + e * src_stride, N * sizeof(float));
+    }
+}
+
+struct ComponentDecoder {
+    uint32_t           size{};
+    ComponentConverter convert{};
+    ComponentConverter convert_normalized{};
+};
+
+// indexed by cgltf_component_type. unsigned int and float accessors can't be normalized
+constexpr ComponentDecoder component_decoders[] = {
+    {},
+    {sizeof(int8_t), convert_components<int8_t>, convert_normalized_components<int8_t>},
+    {sizeof(uint8_t), convert_components<uint8_t>, convert_normalized_components<uint8_t>},
+    {sizeof(int16_t), convert_components<int16_t>, convert_normalized_components<int16_t>},
+    {sizeof(uint16_t), convert_components<uint16_t>, convert_normalized_components<uint16_t>},
+    {sizeof(uint32_t), convert_components<uint32_t>, convert_components<uint32_t>},
+    {sizeof(float), copy_floats, copy_floats},
+};
+
+// decode element_count elements that start stride bytes apart at src, a block at a time, and hand each decoded block to write along with the
+// index of its first element
+template <typename W>
+static void decode_elements(const cgltf_accessor* accessor, const uint8_t* src, uint64_t stride, uint64_t element_count, const W& write) {
+    const ComponentDecoder*  decoder                = &component_decoders[accessor->component_type];
+    const ComponentConverter convert                = accessor->normalized ? decoder->convert_normalized : decoder->convert;
+    const uint32_t           source_component_count = static_cast<uint32_t>(cgltf_num_components(accessor->type));
+    const uint32_t           element_size           = source_component_count * decoder->size;
+
+    uint8_t packed[decode_block_element_count * max_element_size];
+    float   decoded[decode_block_element_count * max_element_size / sizeof(float)];
+    for (uint64_t block_first = 0; block_first < element_count; block_first += decode_block_element_count) {
+        const uint64_t block_count = std::min(decode_block_element_count, element_count - block_first);
+        const uint8_t* block_src   = src + block_first * stride;
+        if (stride != element_size) {
+            for (uint64_t e = 0; e < block_count; e++) {
+                memcpy(packed + e * element_size, block_src + e * stride, element_size);
+            }
+            block_src = packed;
+        }
+
+        convert(block_src, block_count * source_component_count, decoded);
+        write(block_first, block_count, decoded);
+    }
+}
+
+[[nodiscard]] static uint32_t read_sparse_index(const uint8_t* indices, cgltf_component_type component_type, uint64_t i) {
+    switch (component_type) {
+    case cgltf_component_type_r_8u:
+        return indices[i];
+    case cgltf_component_type_r_16u: {
+        uint16_t index;
+        memcpy(&index, indices + i * sizeof(uint16_t), sizeof(uint16_t));
+        return index;
+    }
+    default: {
+        uint32_t index;
+        memcpy(&index, indices + i * sizeof(uint32_t), sizeof(uint32_t));
+        return index;
+    }
+    }
+}
+
+[[nodiscard]] static const uint8_t* get_sparse_indices(const cgltf_accessor* accessor) {
+    const cgltf_accessor_sparse* sparse = &accessor->sparse;
+    return static_cast<const uint8_t*>(sparse->indices_buffer_view->buffer->data) + sparse->indices_buffer_view->offset + sparse->indices_byte_offset;
+}
+
+// the range [first, end) of sparse entries whose indices fall into [first_element, first_element + element_count). sparse indices are
+// strictly increasing, so the range is found with binary searches
+static void find_sparse_range(const cgltf_accessor* accessor, uint64_t first_element, uint64_t element_count, uint64_t* first, uint64_t* end) {
+    const uint8_t*             indices        = get_sparse_indices(accessor);
+    const cgltf_component_type component_type = accessor->sparse.indices_component_type;
+
+    const auto lower_bound = [&](uint64_t element) {
+        uint64_t low  = 0;
+        uint64_t high = accessor->sparse.count;
+        while (low < high) {
+            const uint64_t middle = (low + high) / 2;
+            if (read_sparse_index(indices, component_type, middle) < element) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    };
+
+    *first = lower_bound(first_element);
+    *end   = lower_bound(first_element + element_count);
+}
+
+void decode_accessor(const cgltf_accessor* accessor, uint64_t first_element, uint64_t element_count, uint32_t component_count, void* dst,
+                     uint64_t dst_stride) {
+    if (accessor->component_type >= std::size(component_decoders) || component_decoders[accessor->component_type].size == 0 ||
+        cgltf_num_components(accessor->type) > max_component_count) {
+        abort_message("Cannot decode accessor of type " + std::to_string(accessor->type) + " with component type " +
+                      std::to_string(accessor->component_type));
+    }
+
+    const ComponentDecoder* decoder                = &component_decoders[accessor->component_type];
+    const uint32_t          source_component_count = static_cast<uint32_t>(cgltf_num_components(accessor->type));
+    const uint32_t          element_size           = source_component_count * decoder->size;
+    const uint32_t          written_size           = std::min(component_count, source_component_count) * sizeof(float);
+    uint8_t*                dst_bytes              = static_cast<uint8_t*>(dst);
+
+    // the dense base. sparse accessors without a buffer view start out as zeros
+    if (accessor->buffer_view == nullptr) {
+        for (uint64_t e = 0; e < element_count; e++) {
+            memset(dst_bytes + e * dst_stride, 0, written_size);
+        }
+    } else {
+        const uint8_t* src = static_cast<const uint8_t*>(accessor->buffer_view->buffer->data) + accessor->buffer_view->offset + accessor->offset +
+                             first_element * accessor->stride;
+
+        // tightly packed floats going to tightly packed floats of the same width are copied in one go
+        const bool float_elements = accessor->component_type == cgltf_component_type_r_32f && written_size == element_size;
+        if (float_elements && accessor->stride == element_size && dst_stride == element_size) {
+            memcpy(dst, src, element_count * element_size);
+        } else if (float_elements && source_component_count == 2) {
+            copy_strided_floats<2>(src, accessor->stride, element_count, dst_bytes, dst_stride);
+        } else if (float_elements && source_component_count == 3) {
+            copy_strided_floats<3>(src, accessor->stride, element_count, dst_bytes, dst_stride);
+        } else if (float_elements && source_component_count == 4) {
+            copy_strided_floats<4>(src, accessor->stride, element_count, dst_bytes, dst_stride);
+        } else {
+            decode_elements(accessor, src, accessor->stride, element_count, [&](uint64_t block_first, uint64_t block_count, const float* decoded) {
+                for (uint64_t e = 0; e < block_count; e++) {
+                    memcpy(dst_bytes + (block_first + e) * dst_stride, decoded + e * source_component_count, written_size);
+                }
+            });
+        }
+    }
+
+    if (!accessor->is_sparse) {
+        return;
+    }
+
+    // sparse values are tightly packed elements of the accessor's own type. the ones in range are decoded in blocks like dense elements, with
+    // the simd conversions, and then scattered over the base. the scatter is a scalar loop: sse2, avx2 and neon have no scatter stores, and
+    // each element lands dst_stride bytes apart at an arbitrary index, so a vector version would still store one element at a time
+    uint64_t first_value, end_value;
+    find_sparse_range(accessor, first_element, element_count, &first_value, &end_value);
+
+    const cgltf_accessor_sparse* sparse  = &accessor->sparse;
+    const uint8_t*               indices = get_sparse_indices(accessor);
+    const uint8_t*               values  = static_cast<const uint8_t*>(sparse->values_buffer_view->buffer->data) +
+                            sparse->values_buffer_view->offset + sparse->values_byte_offset + first_value * element_size;
+    decode_elements(accessor, values, element_size, end_value - first_value, [&](uint64_t block_first, uint64_t block_count, const float* decoded) {
+        for (uint64_t v = 0; v < block_count; v++) {
+            const uint64_t element = read_sparse_index(indices, sparse->indices_component_type, first_value + block_first + v) - first_element;
+            memcpy(dst_bytes + element * dst_stride, decoded + v * source_component_count, written_size);
+        }
+    });
+}
+
+void decode_accessor_indices(const cgltf_accessor* accessor, uint64_t first_index, uint64_t index_count, uint32_t* dst) {
+    if (accessor->buffer_view == nullptr) {
+        memset(dst, 0, index_count * sizeof(uint32_t));
+    } else {
+        const uint8_t* index_data =
+            static_cast<const uint8_t*>(accessor->buffer_view->buffer->data) + accessor->offset + accessor->buffer_view->offset;
+
+        switch (accessor->component_type) {
+        case cgltf_component_type_r_8u:
+            for (uint64_t k = 0; k < index_count; k++) {
+                dst[k] = index_data[(first_index + k) * accessor->stride];
+            }
+            break;
+        case cgltf_component_type_r_16u:
+            for (uint64_t k = 0; k < index_count; k++) {
+                uint16_t index;
+                memcpy(&index, index_data + (first_index + k) * accessor->stride, sizeof(uint16_t));
+                dst[k] = index;
+            }
+            break;
+        default:
+            for (uint64_t k = 0; k < index_count; k++) {
+                memcpy(&dst[k], index_data + (first_index + k) * accessor->stride, sizeof(uint32_t));
+            }
+            break;
+        }
+    }
+
+    if (!accessor->is_sparse) {
+        return;
+    }
+
+    uint64_t first_value, end_value;
+    find_sparse_range(accessor, first_index, index_count, &first_value, &end_value);
+
+    // scalar for the same reason as the scatter in decode_accessor
+    const cgltf_accessor_sparse* sparse  = &accessor->sparse;
+    const uint8_t*               indices = get_sparse_indices(accessor);
+    const uint8_t*               values  = static_cast<const uint8_t*>(sparse->values_buffer_view->buffer->data) +
+                            sparse->values_buffer_view->offset + sparse->values_byte_offset;
+    for (uint64_t v = first_value; v < end_value; v++) {
+        dst[read_sparse_index(indices, sparse->indices_component_type, v) - first_index] = read_sparse_index(values, accessor->component_type, v);
+    }
+}
+
+float decode_accessor_bound(const cgltf_accessor* accessor, float bound) {
+    if (!accessor->normalized) {
+        return bound;
+    }
+    switch (accessor->component_type) {
+    case cgltf_component_type_r_8:
+        return normalize_component<int8_t>(bound);
+    case cgltf_component_type_r_8u:
+        return normalize_component<uint8_t>(bound);
+    case cgltf_component_type_r_16:
+        return normalize_component<int16_t>(bound);
+    case cgltf_component_type_r_16u:
+        return normalize_component<uint16_t>(bound);
+    default:
+        return bound;
+    }
+}
+
+} // namespace vk_gltf
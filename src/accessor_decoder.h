@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cgltf.h>
+#include <cstdint>
+
+namespace vk_gltf {
+
+// decode the elements [first_element, first_element + element_count) of an accessor to floats. integer components are converted as is, or
+// mapped to [0, 1] and [-1, 1] when the accessor is normalized, which covers KHR_mesh_quantization. the first component_count components of
+// each element are written, or fewer if the accessor has fewer, with dst_stride bytes from one element to the next. sparse accessors are
+// materialized in place: their base, or zeros without a buffer view, is written first and the sparse values in range are scattered over it
+void decode_accessor(const cgltf_accessor* accessor, uint64_t first_element, uint64_t element_count, uint32_t component_count, void* dst,
+                     uint64_t dst_stride);
+
+// widen the indices [first_index, first_index + index_count) of an index accessor to uint32. like decode_accessor, sparse accessors are
+// materialized from their base, or zeros, with their sparse values applied on top
+void decode_accessor_indices(const cgltf_accessor* accessor, uint64_t first_index, uint64_t index_count, uint32_t* dst);
+
+// a value of the accessor's min or max, converted like its components. bounds are stored in the component type's range
+[[nodiscard]] float decode_accessor_bound(const cgltf_accessor* accessor, float bound);
+
+} // namespace vk_gltf
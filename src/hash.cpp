@@ -0,0 +1,98 @@
+#include "hash.h"
+
+#include <cstring>
+
+namespace vk_gltf {
+
+constexpr uint64_t prime_1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t prime_2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t prime_3 = 0x165667B19E3779F9ull;
+constexpr uint64_t prime_4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t prime_5 = 0x27D4EB2F165667C5ull;
+
+static uint64_t rotate_left(uint64_t value, uint32_t amount) { return (value << amount) | (value >> (64 - amount)); }
+
+// inputs are read as little endian, which every platform we target is
+static uint64_t read_64(const uint8_t* data) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint32_t read_32(const uint8_t* data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint64_t hash_round(uint64_t accumulator, uint64_t input) {
+    accumulator += input * prime_2;
+    accumulator = rotate_left(accumulator, 31);
+    return accumulator * prime_1;
+}
+
+static uint64_t merge_round(uint64_t hash, uint64_t accumulator) {
+    hash ^= hash_round(0, accumulator);
+    return hash * prime_1 + prime_4;
+}
+
+uint64_t hash_64(const void* data, uint64_t size, uint64_t seed) {
+    const uint8_t* input = static_cast<const uint8_t*>(data);
+    const uint8_t* end   = input + size;
+
+    uint64_t hash;
+    if (size >= 32) {
+        // four independent lanes over 32 byte stripes
+        uint64_t v1 = seed + prime_1 + prime_2;
+        uint64_t v2 = seed + prime_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - prime_1;
+
+        const uint8_t* stripes_end = end - 32;
+        do {
+            v1 = hash_round(v1, read_64(input));
+            v2 = hash_round(v2, read_64(input + 8));
+            v3 = hash_round(v3, read_64(input + 16));
+            v4 = hash_round(v4, read_64(input + 24));
+            input += 32;
+        } while (input <= stripes_end);
+
+        hash = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+        hash = merge_round(hash, v1);
+        hash = merge_round(hash, v2);
+        hash = merge_round(hash, v3);
+        hash = merge_round(hash, v4);
+    } else {
+        hash = seed + prime_5;
+    }
+
+    hash += size;
+
+    // tail that did not fill a stripe
+    while (input + 8 <= end) {
+        hash ^= hash_round(0, read_64(input));
+        hash = rotate_left(hash, 27) * prime_1 + prime_4;
+        input += 8;
+    }
+    if (input + 4 <= end) {
+        hash ^= read_32(input) * prime_1;
+        hash = rotate_left(hash, 23) * prime_2 + prime_3;
+        input += 4;
+    }
+    while (input < end) {
+        hash ^= *input * prime_5;
+        hash = rotate_left(hash, 11) * prime_1;
+        input++;
+    }
+
+    // avalanche
+    hash ^= hash >> 33;
+    hash *= prime_2;
+    hash ^= hash >> 29;
+    hash *= prime_3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+} // namespace vk_gltf
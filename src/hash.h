@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+namespace vk_gltf {
+
+// 64 bit xxHash (XXH64) of size bytes. fast enough to hash every source image on each load
+[[nodiscard]] uint64_t hash_64(const void* data, uint64_t size, uint64_t seed = 0);
+
+} // namespace vk_gltf
@@ -0,0 +1,84 @@
+#include "ktx2_image.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace vk_gltf {
+
+constexpr uint8_t ktx2_identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+// fixed size part of a KTX2 file that follows the identifier, up to the supercompression global data fields which are not needed here
+struct Ktx2Header {
+    uint32_t vk_format;
+    uint32_t type_size;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t layer_count;
+    uint32_t face_count;
+    uint32_t level_count;
+    uint32_t supercompression_scheme;
+    uint32_t dfd_byte_offset;
+    uint32_t dfd_byte_length;
+    uint32_t kvd_byte_offset;
+    uint32_t kvd_byte_length;
+};
+
+// the level index follows the header and the two 64 bit supercompression global data fields
+constexpr uint64_t ktx2_level_index_offset = 80;
+
+struct Ktx2LevelIndex {
+    uint64_t byte_offset;
+    uint64_t byte_length;
+    uint64_t uncompressed_byte_length;
+};
+
+static_assert(sizeof(Ktx2Header) == 52);
+static_assert(sizeof(Ktx2LevelIndex) == 24);
+
+bool is_ktx2_data(const uint8_t* data, uint64_t size) {
+    return size >= sizeof(ktx2_identifier) && memcmp(data, ktx2_identifier, sizeof(ktx2_identifier)) == 0;
+}
+
+bool ktx2_image_parse(const uint8_t* data, uint64_t size, Ktx2Image* image) {
+    if (size < ktx2_level_index_offset || !is_ktx2_data(data, size)) {
+        return false;
+    }
+
+    Ktx2Header header;
+    memcpy(&header, data + sizeof(ktx2_identifier), sizeof(header));
+
+    // a format of undefined means basis universal data, which has to be transcoded
+    if (header.vk_format == VK_FORMAT_UNDEFINED || header.supercompression_scheme != 0 || header.pixel_depth > 1 || header.layer_count > 1 ||
+        header.face_count != 1 || header.pixel_width == 0 || header.pixel_height == 0) {
+        return false;
+    }
+
+    // a level count of 0 asks the reader to generate mipmaps, which there is only a base level for
+    const uint32_t level_count = std::max(header.level_count, 1u);
+    if (ktx2_level_index_offset + level_count * sizeof(Ktx2LevelIndex) > size) {
+        return false;
+    }
+
+    image->format = static_cast<VkFormat>(header.vk_format);
+    image->extent = {header.pixel_width, header.pixel_height, 1};
+    image->levels.clear();
+    image->levels.reserve(level_count);
+    for (uint32_t level = 0; level < level_count; level++) {
+        Ktx2LevelIndex level_index;
+        memcpy(&level_index, data + ktx2_level_index_offset + level * sizeof(Ktx2LevelIndex), sizeof(level_index));
+        if (level_index.byte_offset > size || level_index.byte_length > size - level_index.byte_offset) {
+            return false;
+        }
+
+        ImageLevelUpload level_upload{};
+        level_upload.data   = data + level_index.byte_offset;
+        level_upload.size   = level_index.byte_length;
+        level_upload.extent = {std::max(header.pixel_width >> level, 1u), std::max(header.pixel_height >> level, 1u), 1};
+        image->levels.push_back(level_upload);
+    }
+
+    return true;
+}
+
+} // namespace vk_gltf
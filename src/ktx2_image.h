@@ -0,0 +1,24 @@
+#pragma once
+
+#include "staging_ring.h"
+
+#include <vector>
+
+namespace vk_gltf {
+
+// a 2d KTX2 file without supercompression, parsed in place. level data points into the file's bytes, so it can be copied straight into staging
+// memory
+struct Ktx2Image {
+    VkFormat                      format{};
+    VkExtent3D                    extent{};
+    std::vector<ImageLevelUpload> levels{};
+};
+
+// whether data starts with the KTX2 file identifier
+[[nodiscard]] bool is_ktx2_data(const uint8_t* data, uint64_t size);
+
+// returns false if data is not a KTX2 file, or uses features that cannot be uploaded without libktx (supercompression, basis, arrays, cubemaps,
+// 3d images)
+[[nodiscard]] bool ktx2_image_parse(const uint8_t* data, uint64_t size, Ktx2Image* image);
+
+} // namespace vk_gltf
@@ -4,61 +4,33 @@
 #define KHRONOS_STATIC
 #endif
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
 #include <functional>
+#include <future>
 #include <ktx.h>
+#include <queue>
+#include <random>
 #include <thread>
+#include <unordered_set>
 
 #include "stb_image.h"
 #include <cgltf.h>
 #include <iostream>
 
-#include <vulkan/vk_enum_string_helper.h>
+#include "accessor_decoder.h"
+#include "hash.h"
+#include "ktx2_image.h"
+#include "mapped_file.h"
+#include "mip_generator.h"
+#include "staging_ring.h"
+#include "utils.h"
+#include "worker_pool.h"
 
 namespace vk_gltf {
 
-[[noreturn]] static void abort_message(const std::string_view message) {
-    std::cerr << message << std::endl;
-    std::abort();
-}
-
-#define VK_CHECK(x)                                                                                                                                  \
-    do {                                                                                                                                             \
-        VkResult err = x;                                                                                                                            \
-        if (err) {                                                                                                                                   \
-            std::cerr << "Detected Vulkan error: " << string_VkResult(err) << std::endl;                                                             \
-            abort();                                                                                                                                 \
-        }                                                                                                                                            \
-    } while (0)
-
-static void vk_command_immediate_submit(VkDevice device, VkCommandPool command_pool, VkQueue queue,
-                                        std::function<void(VkCommandBuffer command_buffer)>&& function) {
-    VkFence                 fence{};
-    const VkFenceCreateInfo fence_ci = vk_lib::fence_create_info();
-    VK_CHECK(vkCreateFence(device, &fence_ci, nullptr, &fence));
-
-    const VkCommandBufferAllocateInfo command_buffer_ai = vk_lib::command_buffer_allocate_info(command_pool);
-    VkCommandBuffer                   cmd_buf;
-    VK_CHECK(vkAllocateCommandBuffers(device, &command_buffer_ai, &cmd_buf));
-
-    const VkCommandBufferBeginInfo command_buffer_bi = vk_lib::command_buffer_begin_info();
-    VK_CHECK(vkBeginCommandBuffer(cmd_buf, &command_buffer_bi));
-
-    function(cmd_buf);
-
-    VK_CHECK(vkEndCommandBuffer(cmd_buf));
-
-    const VkCommandBufferSubmitInfo command_buffer_submit_info = vk_lib::command_buffer_submit_info(cmd_buf);
-    const VkSubmitInfo2             submit_info_2              = vk_lib::submit_info_2(&command_buffer_submit_info);
-
-    VK_CHECK(vkQueueSubmit2(queue, 1, &submit_info_2, fence));
-
-    VK_CHECK(vkWaitForFences(device, 1, &fence, true, UINT64_MAX));
-
-    vkFreeCommandBuffers(device, command_pool, 1, &cmd_buf);
-
-    vkDestroyFence(device, fence, nullptr);
-}
-
 static std::string cgltf_result_to_string(cgltf_result result) {
     switch (result) {
     case cgltf_result_success:
@@ -88,586 +60,2252 @@ static std::string cgltf_result_to_string(cgltf_result result) {
     }
 }
 
-static void get_format_for_image(const cgltf_data* cgltf_data, uint32_t image_index, uint32_t color_channels, VkFormat* uncompressed_vk_format,
-                                 VkFormat* ideal_compressed_vk_format, ktx_transcode_fmt_e* ktx_transcode_format) {
-    const cgltf_image* target_image = &cgltf_data->images[image_index];
-    bool               is_srgb      = true; // default to sRGB, we'll set to false for data textures
+// a format is usable when optimally tiled images of it can be uploaded to and sampled with linear filtering
+[[nodiscard]] static bool is_texture_format_supported(VkPhysicalDevice physical_device, VkFormat format) {
+    constexpr VkFormatFeatureFlags required_features =
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
 
-    for (uint32_t i = 0; i < cgltf_data->materials_count; i++) {
-        const cgltf_material* material = &cgltf_data->materials[i];
-        if (material->normal_texture.texture && material->normal_texture.texture->image == target_image) {
-            is_srgb = false;
-            break;
+    VkFormatProperties format_properties;
+    vkGetPhysicalDeviceFormatProperties(physical_device, format, &format_properties);
+    return (format_properties.optimalTilingFeatures & required_features) == required_features;
+}
+
+// textures are transcoded to the first format in their chain that the device supports. every chain ends in rgba8, which is always supported.
+// the srgb or unorm variant of the chosen format is picked by libktx from the transfer function of the source texture
+static void choose_texture_target(const TextureFormatSupport* format_support, uint32_t channel_count, TextureTarget* texture_target,
+                                  ktx_transcode_fmt_e* ktx_transcode_format) {
+    switch (channel_count) {
+    case 1:
+        if (format_support->bc4) {
+            *texture_target       = TextureTarget::bc4;
+            *ktx_transcode_format = KTX_TTF_BC4_R;
+            return;
+        }
+        if (format_support->eac_r11) {
+            *texture_target       = TextureTarget::eac_r11;
+            *ktx_transcode_format = KTX_TTF_ETC2_EAC_R11;
+            return;
+        }
+        break;
+    case 2:
+        if (format_support->bc5) {
+            *texture_target       = TextureTarget::bc5;
+            *ktx_transcode_format = KTX_TTF_BC5_RG;
+            return;
+        }
+        if (format_support->eac_rg11) {
+            *texture_target       = TextureTarget::eac_rg11;
+            *ktx_transcode_format = KTX_TTF_ETC2_EAC_RG11;
+            return;
         }
+        break;
+    default:
+        if (format_support->bc7) {
+            *texture_target       = TextureTarget::bc7;
+            *ktx_transcode_format = KTX_TTF_BC7_RGBA;
+            return;
+        }
+        if (format_support->astc_4x4) {
+            *texture_target       = TextureTarget::astc_4x4;
+            *ktx_transcode_format = KTX_TTF_ASTC_4x4_RGBA;
+            return;
+        }
+        if (format_support->etc2_rgba) {
+            *texture_target       = TextureTarget::etc2_rgba;
+            *ktx_transcode_format = KTX_TTF_ETC2_RGBA;
+            return;
+        }
+        break;
+    }
 
-        if (material->occlusion_texture.texture && material->occlusion_texture.texture->image == target_image) {
-            is_srgb = false;
-            break;
+    *texture_target       = TextureTarget::rgba8;
+    *ktx_transcode_format = KTX_TTF_RGBA32;
+}
+
+// family of a ktx2 source that is already in a gpu format
+[[nodiscard]] static TextureTarget get_format_texture_target(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+        return TextureTarget::bc7;
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+        return TextureTarget::bc5;
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+        return TextureTarget::bc4;
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+        return TextureTarget::astc_4x4;
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+        return TextureTarget::etc2_rgba;
+    case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+        return TextureTarget::eac_rg11;
+    case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+        return TextureTarget::eac_r11;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        return TextureTarget::rgba8;
+    default:
+        return TextureTarget::native;
+    }
+}
+
+// slots that hold colors, and are stored in srgb
+constexpr uint32_t texture_usage_color_mask = texture_usage_base_color | texture_usage_emissive | texture_usage_diffuse |
+                                              texture_usage_specular_glossiness | texture_usage_sheen_color | texture_usage_specular_color;
+// slots that hold tangent space normals, of which only x and y are stored
+constexpr uint32_t texture_usage_normal_mask = texture_usage_normal | texture_usage_clearcoat_normal;
+
+// rgba channels a data slot reads, as bits 0 to 3
+[[nodiscard]] static uint32_t get_texture_usage_channels(TextureUsage usage) {
+    switch (usage) {
+    case texture_usage_occlusion:
+    case texture_usage_clearcoat:
+    case texture_usage_transmission:
+        return 0b0001;
+    case texture_usage_clearcoat_roughness:
+    case texture_usage_thickness:
+        return 0b0010;
+    case texture_usage_metallic_roughness:
+        return 0b0110;
+    case texture_usage_sheen_roughness:
+    case texture_usage_specular:
+        return 0b1000;
+    default:
+        return 0b1111;
+    }
+}
+
+// textures with a KHR_texture_basisu source use it instead of their fallback image
+[[nodiscard]] static const cgltf_image* get_texture_image(const cgltf_texture* texture) {
+    return texture->has_basisu && texture->basisu_image ? texture->basisu_image : texture->image;
+}
+
+// images that are only the fallback of textures that also have a KHR_texture_basisu source are never sampled, so they are not loaded
+[[nodiscard]] static std::vector<bool> get_fallback_only_images(const cgltf_data* cgltf_data) {
+    std::vector<bool> is_fallback(cgltf_data->images_count, false);
+    std::vector<bool> is_used(cgltf_data->images_count, false);
+    for (uint32_t i = 0; i < cgltf_data->textures_count; i++) {
+        const cgltf_texture* texture = &cgltf_data->textures[i];
+        if (const cgltf_image* image = get_texture_image(texture)) {
+            is_used[image - cgltf_data->images] = true;
+        }
+        if (texture->has_basisu && texture->basisu_image && texture->image) {
+            is_fallback[texture->image - cgltf_data->images] = true;
         }
+    }
 
-        if (material->has_pbr_metallic_roughness && material->pbr_metallic_roughness.metallic_roughness_texture.texture &&
-            material->pbr_metallic_roughness.metallic_roughness_texture.texture->image == target_image) {
-            is_srgb = false;
-            break;
+    std::vector<bool> fallback_only(cgltf_data->images_count);
+    for (uint32_t i = 0; i < cgltf_data->images_count; i++) {
+        fallback_only[i] = is_fallback[i] && !is_used[i];
+    }
+
+    return fallback_only;
+}
+
+// call visit with every texture slot of material and the usage it stands for, including the slots of unset textures
+static void visit_material_textures(const cgltf_material* material, const std::function<void(const cgltf_texture_view*, TextureUsage)>& visit) {
+    visit(&material->normal_texture, texture_usage_normal);
+    visit(&material->occlusion_texture, texture_usage_occlusion);
+    visit(&material->emissive_texture, texture_usage_emissive);
+    if (material->has_pbr_metallic_roughness) {
+        visit(&material->pbr_metallic_roughness.base_color_texture, texture_usage_base_color);
+        visit(&material->pbr_metallic_roughness.metallic_roughness_texture, texture_usage_metallic_roughness);
+    }
+    if (material->has_pbr_specular_glossiness) {
+        visit(&material->pbr_specular_glossiness.diffuse_texture, texture_usage_diffuse);
+        visit(&material->pbr_specular_glossiness.specular_glossiness_texture, texture_usage_specular_glossiness);
+    }
+    if (material->has_clearcoat) {
+        visit(&material->clearcoat.clearcoat_texture, texture_usage_clearcoat);
+        visit(&material->clearcoat.clearcoat_roughness_texture, texture_usage_clearcoat_roughness);
+        visit(&material->clearcoat.clearcoat_normal_texture, texture_usage_clearcoat_normal);
+    }
+    if (material->has_transmission) {
+        visit(&material->transmission.transmission_texture, texture_usage_transmission);
+    }
+    if (material->has_sheen) {
+        visit(&material->sheen.sheen_color_texture, texture_usage_sheen_color);
+        visit(&material->sheen.sheen_roughness_texture, texture_usage_sheen_roughness);
+    }
+    if (material->has_specular) {
+        visit(&material->specular.specular_texture, texture_usage_specular);
+        visit(&material->specular.specular_color_texture, texture_usage_specular_color);
+    }
+    if (material->has_volume) {
+        visit(&material->volume.thickness_texture, texture_usage_thickness);
+    }
+}
+
+constexpr uint32_t unselected_index = UINT32_MAX;
+
+// cgltf indices of one kind of resource that a load keeps
+struct IndexSelection {
+    // in file order, so a load without a filter keeps every index where it is
+    std::vector<uint32_t> kept{};
+    // asset index of every cgltf index, or unselected_index
+    std::vector<uint32_t> asset_index{};
+};
+
+// everything a load keeps. resources nothing selected references are dropped, and the kept ones are renumbered densely
+struct LoadSelection {
+    IndexSelection scenes{};
+    IndexSelection nodes{};
+    IndexSelection meshes{};
+    IndexSelection materials{};
+    IndexSelection textures{};
+    IndexSelection images{};
+    IndexSelection samplers{};
+    IndexSelection lights{};
+};
+
+[[nodiscard]] static IndexSelection select_indices(const std::vector<bool>& is_selected) {
+    IndexSelection selection{};
+    selection.asset_index.resize(is_selected.size(), unselected_index);
+    for (uint32_t i = 0; i < is_selected.size(); i++) {
+        if (is_selected[i]) {
+            selection.asset_index[i] = static_cast<uint32_t>(selection.kept.size());
+            selection.kept.push_back(i);
+        }
+    }
+    return selection;
+}
+
+[[nodiscard]] static IndexSelection select_all_indices(size_t count) { return select_indices(std::vector<bool>(count, true)); }
+
+// walk the node graph from the scene or nodes load_options selects, and keep every resource the reachable nodes reference
+[[nodiscard]] static LoadSelection get_load_selection(const LoadOptions* load_options, const cgltf_data* cgltf_data) {
+    LoadSelection selection{};
+    if (!load_options->scene_index.has_value() && load_options->node_filter.empty()) {
+        selection.scenes    = select_all_indices(cgltf_data->scenes_count);
+        selection.nodes     = select_all_indices(cgltf_data->nodes_count);
+        selection.meshes    = select_all_indices(cgltf_data->meshes_count);
+        selection.materials = select_all_indices(cgltf_data->materials_count);
+        selection.textures  = select_all_indices(cgltf_data->textures_count);
+        selection.images    = select_all_indices(cgltf_data->images_count);
+        selection.samplers  = select_all_indices(cgltf_data->samplers_count);
+        selection.lights    = select_all_indices(cgltf_data->lights_count);
+        return selection;
+    }
+
+    std::vector<bool>     is_scene_selected(cgltf_data->scenes_count, false);
+    std::vector<uint32_t> pending_nodes;
+    if (!load_options->node_filter.empty()) {
+        pending_nodes = load_options->node_filter;
+    } else {
+        const uint32_t scene_index = load_options->scene_index.value();
+        if (scene_index >= cgltf_data->scenes_count) {
+            abort_message("Scene index " + std::to_string(scene_index) + " is out of range");
         }
+        is_scene_selected[scene_index] = true;
+        const cgltf_scene* scene       = &cgltf_data->scenes[scene_index];
+        for (uint32_t i = 0; i < scene->nodes_count; i++) {
+            pending_nodes.push_back(static_cast<uint32_t>(scene->nodes[i] - cgltf_data->nodes));
+        }
+    }
 
-        if (material->has_pbr_specular_glossiness && material->pbr_specular_glossiness.specular_glossiness_texture.texture &&
-            material->pbr_specular_glossiness.specular_glossiness_texture.texture->image == target_image) {
-            is_srgb = false;
-            break;
+    std::vector<bool> is_node_selected(cgltf_data->nodes_count, false);
+    std::vector<bool> is_mesh_selected(cgltf_data->meshes_count, false);
+    std::vector<bool> is_light_selected(cgltf_data->lights_count, false);
+    while (!pending_nodes.empty()) {
+        const uint32_t node_index = pending_nodes.back();
+        pending_nodes.pop_back();
+        if (node_index >= cgltf_data->nodes_count) {
+            abort_message("Node index " + std::to_string(node_index) + " is out of range");
+        }
+        if (is_node_selected[node_index]) {
+            continue;
         }
+        is_node_selected[node_index] = true;
 
-        if (material->has_clearcoat) {
-            if (material->clearcoat.clearcoat_roughness_texture.texture &&
-                material->clearcoat.clearcoat_roughness_texture.texture->image == target_image) {
-                is_srgb = false;
-                break;
+        const cgltf_node* node = &cgltf_data->nodes[node_index];
+        for (uint32_t i = 0; i < node->children_count; i++) {
+            pending_nodes.push_back(static_cast<uint32_t>(node->children[i] - cgltf_data->nodes));
+        }
+        if (node->mesh) {
+            is_mesh_selected[node->mesh - cgltf_data->meshes] = true;
+        }
+        if (node->light) {
+            is_light_selected[node->light - cgltf_data->lights] = true;
+        }
+    }
+
+    std::vector<bool> is_material_selected(cgltf_data->materials_count, false);
+    for (uint32_t i = 0; i < cgltf_data->meshes_count; i++) {
+        if (!is_mesh_selected[i]) {
+            continue;
+        }
+        const cgltf_mesh* mesh = &cgltf_data->meshes[i];
+        for (uint32_t j = 0; j < mesh->primitives_count; j++) {
+            if (mesh->primitives[j].material) {
+                is_material_selected[mesh->primitives[j].material - cgltf_data->materials] = true;
             }
+        }
+    }
 
-            if (material->clearcoat.clearcoat_normal_texture.texture && material->clearcoat.clearcoat_normal_texture.texture->image == target_image) {
-                is_srgb = false;
-                break;
+    std::vector<bool> is_texture_selected(cgltf_data->textures_count, false);
+    for (uint32_t i = 0; i < cgltf_data->materials_count; i++) {
+        if (!is_material_selected[i]) {
+            continue;
+        }
+        visit_material_textures(&cgltf_data->materials[i], [&](const cgltf_texture_view* texture_view, TextureUsage) {
+            if (texture_view->texture) {
+                is_texture_selected[texture_view->texture - cgltf_data->textures] = true;
             }
+        });
+    }
+
+    // the fallback image of a texture with a KHR_texture_basisu source is never loaded, so it is not kept either
+    std::vector<bool> is_image_selected(cgltf_data->images_count, false);
+    std::vector<bool> is_sampler_selected(cgltf_data->samplers_count, false);
+    for (uint32_t i = 0; i < cgltf_data->textures_count; i++) {
+        if (!is_texture_selected[i]) {
+            continue;
+        }
+        const cgltf_texture* texture = &cgltf_data->textures[i];
+        if (const cgltf_image* image = get_texture_image(texture)) {
+            is_image_selected[image - cgltf_data->images] = true;
         }
+        if (texture->sampler) {
+            is_sampler_selected[texture->sampler - cgltf_data->samplers] = true;
+        }
+    }
 
-        if (material->has_transmission && material->transmission.transmission_texture.texture &&
-            material->transmission.transmission_texture.texture->image == target_image) {
-            is_srgb = false;
-            break;
+    selection.scenes    = select_indices(is_scene_selected);
+    selection.nodes     = select_indices(is_node_selected);
+    selection.meshes    = select_indices(is_mesh_selected);
+    selection.materials = select_indices(is_material_selected);
+    selection.textures  = select_indices(is_texture_selected);
+    selection.images    = select_indices(is_image_selected);
+    selection.samplers  = select_indices(is_sampler_selected);
+    selection.lights    = select_indices(is_light_selected);
+
+    return selection;
+}
+
+// every material slot is visited once, so classifying the kept images costs O(materials) instead of O(images * materials). only kept materials
+// count, so slots of dropped materials don't change how an image is encoded
+[[nodiscard]] static std::vector<uint32_t> get_image_usages(const cgltf_data* cgltf_data, const LoadSelection* selection) {
+    std::vector<uint32_t> image_usages(cgltf_data->images_count, 0);
+
+    for (uint32_t material_index : selection->materials.kept) {
+        visit_material_textures(&cgltf_data->materials[material_index], [&](const cgltf_texture_view* texture_view, TextureUsage texture_usage) {
+            if (texture_view->texture == nullptr) {
+                return;
+            }
+            if (const cgltf_image* image = get_texture_image(texture_view->texture)) {
+                image_usages[image - cgltf_data->images] |= texture_usage;
+            }
+        });
+    }
+
+    return image_usages;
+}
+
+// channels of the decoded rgba image that an image is encoded with. images only read through one or two channels are stored with just those,
+// so they compress to bc4 or bc5 instead of bc7
+struct TextureLayout {
+    uint32_t channel_count{4};
+    // decoded channel each stored channel comes from. only the first channel_count entries are used
+    uint32_t source_channels[2]{};
+    bool     srgb{true};
+    bool     normal_map{false};
+};
+
+[[nodiscard]] static TextureLayout get_texture_layout(uint32_t usage) {
+    TextureLayout layout{};
+    // images that no material references keep the old default of a 4 channel color texture
+    if (usage == 0 || (usage & texture_usage_color_mask) != 0) {
+        layout.srgb = (usage & ~texture_usage_color_mask) == 0;
+        return layout;
+    }
+
+    layout.srgb = false;
+    if ((usage & texture_usage_normal_mask) == usage) {
+        // z is rebuilt from x and y when sampling
+        layout.channel_count      = 2;
+        layout.source_channels[0] = 0;
+        layout.source_channels[1] = 1;
+        layout.normal_map         = true;
+        return layout;
+    }
+    if ((usage & texture_usage_normal_mask) != 0) {
+        return layout;
+    }
+
+    uint32_t channels = 0;
+    for (uint32_t bit = 0; bit < 32; bit++) {
+        if (usage & (1u << bit)) {
+            channels |= get_texture_usage_channels(static_cast<TextureUsage>(1u << bit));
         }
+    }
 
-        if (material->has_sheen && material->sheen.sheen_roughness_texture.texture &&
-            material->sheen.sheen_roughness_texture.texture->image == target_image) {
-            is_srgb = false;
-            break;
+    uint32_t channel_count = 0;
+    for (uint32_t channel = 0; channel < 4; channel++) {
+        if (channels & (1u << channel)) {
+            if (channel_count < 2) {
+                layout.source_channels[channel_count] = channel;
+            }
+            channel_count++;
         }
     }
+    if (channel_count <= 2) {
+        layout.channel_count = channel_count;
+    }
+
+    return layout;
+}
 
-    switch (color_channels) {
+[[nodiscard]] static VkFormat get_uncompressed_format(const TextureLayout* layout) {
+    switch (layout->channel_count) {
     case 1:
-        *uncompressed_vk_format     = VK_FORMAT_R8_UNORM;
-        *ideal_compressed_vk_format = VK_FORMAT_BC4_UNORM_BLOCK;
-        *ktx_transcode_format       = KTX_TTF_BC4_R;
-        break;
+        return VK_FORMAT_R8_UNORM;
     case 2:
-        *uncompressed_vk_format     = VK_FORMAT_R8G8_UNORM;
-        *ideal_compressed_vk_format = VK_FORMAT_BC5_UNORM_BLOCK;
-        *ktx_transcode_format       = KTX_TTF_BC5_RG;
-        break;
-    case 3:
-        if (is_srgb) {
-            *uncompressed_vk_format     = VK_FORMAT_R8G8B8_SRGB;
-            *ideal_compressed_vk_format = VK_FORMAT_BC7_SRGB_BLOCK;
-        } else {
-            *uncompressed_vk_format     = VK_FORMAT_R8G8B8_UNORM;
-            *ideal_compressed_vk_format = VK_FORMAT_BC7_UNORM_BLOCK;
-        }
-        *ktx_transcode_format = KTX_TTF_BC7_RGBA;
-        break;
-    case 4:
+        return VK_FORMAT_R8G8_UNORM;
     default:
-        if (is_srgb) {
-            *uncompressed_vk_format     = VK_FORMAT_R8G8B8A8_SRGB;
-            *ideal_compressed_vk_format = VK_FORMAT_BC7_SRGB_BLOCK;
-        } else {
-            *uncompressed_vk_format     = VK_FORMAT_R8G8B8A8_UNORM;
-            *ideal_compressed_vk_format = VK_FORMAT_BC7_UNORM_BLOCK;
+        return layout->srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+// view swizzle that puts every stored channel back where the shader reads it. basis stores 2 channel textures as rrrg, so the second channel
+// ends up in g for bc5 and eac rg11, but in a when transcoded to the rgba8 fallback. ktx2 sources already in a gpu format keep it in g
+[[nodiscard]] static VkComponentMapping get_texture_components(const TextureLayout* layout, bool second_channel_in_alpha) {
+    VkComponentMapping components{};
+    if (layout->channel_count == 4) {
+        return components;
+    }
+
+    VkComponentSwizzle mapping[4] = {VK_COMPONENT_SWIZZLE_ZERO, VK_COMPONENT_SWIZZLE_ZERO, VK_COMPONENT_SWIZZLE_ZERO, VK_COMPONENT_SWIZZLE_ONE};
+    if (layout->normal_map) {
+        // a blue of one keeps normal maps usable by shaders that don't rebuild z
+        mapping[2] = VK_COMPONENT_SWIZZLE_ONE;
+    }
+    mapping[layout->source_channels[0]] = VK_COMPONENT_SWIZZLE_R;
+    if (layout->channel_count == 2) {
+        mapping[layout->source_channels[1]] = second_channel_in_alpha ? VK_COMPONENT_SWIZZLE_A : VK_COMPONENT_SWIZZLE_G;
+    }
+
+    components.r = mapping[0];
+    components.g = mapping[1];
+    components.b = mapping[2];
+    components.a = mapping[3];
+
+    return components;
+}
+
+// the kinds of images load options can be set for separately
+enum class TextureRole {
+    color,
+    normal,
+    data,
+};
+
+[[nodiscard]] static TextureRole get_texture_role(uint32_t usage, const TextureLayout* layout) {
+    if (layout->normal_map) {
+        return TextureRole::normal;
+    }
+    if (usage == 0 || (usage & texture_usage_color_mask) != 0) {
+        return TextureRole::color;
+    }
+    return TextureRole::data;
+}
+
+// bump whenever encoder settings or the cache file layout change, so that stale cache entries are never read
+constexpr uint64_t texture_cache_version = 3;
+
+// cache tiers an image can be loaded from. the source tier holds portable UASTC textures, the transcoded tier holds textures already in
+// their final device format, which only have to be copied to the gpu
+enum class CacheTier {
+    none,
+    source,
+    transcoded,
+};
+
+// all state for loading a single gltf image. filled in on the calling thread, then passed between worker jobs and the upload stage
+struct ImageLoadJob {
+    // index into the asset's images, and into the file's images. they differ when a scene or node filter drops images
+    uint32_t image_index{};
+    uint32_t gltf_index{};
+    uint32_t usage{};
+    int      width{};
+    int      height{};
+    // levels the texture is created with. the dropped top levels of the source's chain are not part of it
+    uint32_t mip_levels{1};
+    // top levels of the source's mip chain skipped to fit the texture budget or the max dimension of the image's role
+    uint32_t dropped_levels{0};
+    // first level of the kept chain that is uploaded by load_gltf when textures are streamed. the levels above it are uploaded by
+    // poll_texture_streaming. 0 when the image is not streamed
+    uint32_t            stream_first_level{0};
+    TextureLayout       layout{};
+    TextureRole         role{};
+    EncoderProfile      encoder_profile{};
+    VkFormat            uncompressed_format{};
+    TextureTarget       texture_target{};
+    ktx_transcode_fmt_e ktx_transcode_format{};
+    // format of a ktx2 source that needs no transcoding, which is uploaded as is. undefined for every other image
+    VkFormat native_format{VK_FORMAT_UNDEFINED};
+    // encoded image source. glb images live in the binary chunk, gltf images are external files read into file_data
+    const uint8_t*       encoded_data{};
+    uint64_t             encoded_size{};
+    std::string          uri{};
+    std::vector<uint8_t> file_data{};
+    uint64_t             content_hash{};
+    // set when the encoded bytes already are a ktx2 texture, as with KHR_texture_basisu. those are only transcoded, never encoded
+    bool ktx2_source{false};
+    // images nobody samples are skipped and left as an empty GltfImage. duplicate and shared images are skipped too, and reuse an image
+    // loaded before
+    bool skip{false};
+    // set for images with the same bytes as an earlier image of the asset that is loaded the same way. they share its GltfImage
+    std::optional<uint32_t> duplicate_of{};
+    // key the image is shared across loads under in LoaderContext::shared_images. set when the job was found there
+    uint64_t share_key{};
+    bool     shared{false};
+    // set for TextureMode::uncompressed. the decoded image and its cpu generated mips are uploaded from level_data as they are
+    bool                          uncompressed{false};
+    std::vector<uint8_t>          level_data{};
+    std::vector<ImageLevelUpload> levels{};
+    std::string                   source_cache_path{};
+    std::string                   transcoded_cache_path{};
+    CacheTier                     cache_tier{CacheTier::none};
+    uint8_t*                      img_data{};
+    ktxTexture2*                  ktx_texture{};
+    // transcoded cache entries are mapped and uploaded straight from the mapping instead of going through ktx_texture
+    MappedFile cached_file{};
+    Ktx2Image  cached_image{};
+    // streamed images that are encoded on this load get their tail levels encoded on their own first, so load_gltf does not wait for the
+    // full encode. the job that encodes the tail submits the one that encodes the full chain
+    bool              encodes_tail{false};
+    ktxTexture2*      tail_ktx_texture{};
+    std::future<void> tail_ready{};
+    // signaled once the image, or the full chain of a streamed image, is ready for upload
+    std::future<void> ready{};
+};
+
+static void load_cached_ktx_texture(ImageLoadJob* job) {
+    KTX_error_code result =
+        ktxTexture2_CreateFromNamedFile(job->source_cache_path.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &job->ktx_texture);
+    if (result != KTX_SUCCESS) {
+        const std::string message = "Cannot load file with error code: " + std::to_string(result);
+        abort_message(message);
+    }
+}
+
+// make the encoded bytes of an image available in memory and hash them for the cache key
+static void read_encoded_image(ImageLoadJob* job) {
+    if (job->encoded_data == nullptr) {
+        std::ifstream file(job->uri, std::ios::binary | std::ios::ate);
+        if (!file) {
+            abort_message("Cannot open image file: " + job->uri);
         }
-        *ktx_transcode_format = KTX_TTF_BC7_RGBA;
-        break;
+        job->file_data.resize(file.tellg());
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(job->file_data.data()), static_cast<std::streamsize>(job->file_data.size()));
+
+        job->encoded_data = job->file_data.data();
+        job->encoded_size = job->file_data.size();
     }
+    job->content_hash = hash_64(job->encoded_data, job->encoded_size);
 }
 
-static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size, GltfBuffer* staging_buffer) {
-    if (staging_buffer->allocation_info.size > 0) {
-        vmaDestroyBuffer(allocator, staging_buffer->buffer, staging_buffer->allocation);
+// map a transcoded cache entry and locate its levels in place. nothing is read until the levels are copied into staging memory
+static void map_cached_texture(ImageLoadJob* job) {
+    if (!mapped_file_open(job->transcoded_cache_path, &job->cached_file)) {
+        abort_message("Cannot map cached texture: " + job->transcoded_cache_path);
+    }
+    if (!ktx2_image_parse(job->cached_file.data, job->cached_file.size, &job->cached_image)) {
+        abort_message("Cannot parse cached texture: " + job->transcoded_cache_path);
     }
-    const VkBufferCreateInfo staging_buffer_ci =
-        vk_lib::buffer_create_info(VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, data_size, 0);
-    VmaAllocationCreateInfo allocation_ci{};
-    allocation_ci.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
-    allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
-    VK_CHECK(vmaCreateBuffer(allocator, &staging_buffer_ci, &allocation_ci, &staging_buffer->buffer, &staging_buffer->allocation,
-                             &staging_buffer->allocation_info));
 }
 
-// load gltf images, compress them, then create vulkan images and images views from them
-[[nodiscard]] static std::vector<GltfImage> load_gltf_images(const LoadOptions* load_options, const cgltf_data* cgltf_data, VkDevice device,
-                                                             VmaAllocator allocator, VkCommandPool command_pool, VkQueue queue,
-                                                             GltfBuffer* staging_buffer) {
-    bool check_cache    = false;
-    bool write_to_cache = false;
-    if (!load_options->cache_dir.empty()) {
-        if (std::filesystem::exists(load_options->cache_dir)) {
-            check_cache    = true;
-            write_to_cache = true;
-        } else {
-            // will write to cache only if caller provided a cache directory and the image was not found in the cache
-            write_to_cache = std::filesystem::create_directory(load_options->cache_dir);
+// create job->ktx_texture from a ktx2 image shipped with the asset. zstd supercompressed levels are inflated here
+static void load_ktx2_source(ImageLoadJob* job) {
+    KTX_error_code result = ktxTexture2_CreateFromMemory(job->encoded_data, job->encoded_size, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+                                                         &job->ktx_texture);
+    if (result != KTX_SUCCESS) {
+        const std::string message = "Cannot load ktx2 image with error code: " + std::to_string(result);
+        abort_message(message);
+    }
+
+    job->file_data    = {};
+    job->encoded_data = nullptr;
+    job->encoded_size = 0;
+}
+
+static void decode_image(ImageLoadJob* job, int required_components) {
+    int component_count;
+    job->img_data = stbi_load_from_memory(job->encoded_data, static_cast<int>(job->encoded_size), &job->width, &job->height, &component_count,
+                                          required_components);
+    if (job->img_data == nullptr) {
+        abort_message(stbi_failure_reason());
+    }
+
+    // the encoded bytes are not needed anymore once decoded
+    job->file_data    = {};
+    job->encoded_data = nullptr;
+    job->encoded_size = 0;
+}
+
+[[nodiscard]] static uint32_t get_level_dimension(int base_dimension, uint32_t level) {
+    return std::max(static_cast<uint32_t>(base_dimension) >> level, 1u);
+}
+
+// create an uncompressed texture for the kept levels of the job's mip chain from first_level on
+static void create_ktx_texture(const ImageLoadJob* job, uint32_t first_level, ktxTexture2** ktx_texture) {
+    ktxTextureCreateInfo create_info{};
+    create_info.vkFormat        = job->uncompressed_format;
+    create_info.baseDepth       = 1;
+    create_info.baseWidth       = get_level_dimension(job->width, job->dropped_levels + first_level);
+    create_info.baseHeight      = get_level_dimension(job->height, job->dropped_levels + first_level);
+    create_info.numDimensions   = 2;
+    create_info.numFaces        = 1;
+    create_info.numLayers       = 1;
+    create_info.numLevels       = job->mip_levels - first_level;
+    create_info.isArray         = false;
+    create_info.generateMipmaps = false;
+    KTX_error_code result       = ktxTexture2_Create(&create_info, KTX_TEXTURE_CREATE_ALLOC_STORAGE, ktx_texture);
+    if (result != KTX_SUCCESS) {
+        const std::string message = "Cannot create ktx texture with error code: " + std::to_string(result);
+        abort_message(message);
+    }
+}
+
+// cache entries are shared by every asset, so write to a unique file first and rename it into place. readers never see a partial file, and
+// two loads encoding the same image just replace each other's identical entry
+static void write_ktx_to_cache(ktxTexture2* ktx_texture, const std::string& cache_path) {
+    const std::string temp_path = cache_path + "." + std::to_string(std::random_device{}()) + ".tmp";
+    KTX_error_code    result    = ktxTexture2_WriteToNamedFile(ktx_texture, temp_path.c_str());
+    if (result != KTX_SUCCESS) {
+        const std::string message = "Cannot write ktx data to file with error code: " + std::to_string(result);
+        abort_message(message);
+    }
+    std::filesystem::rename(temp_path, cache_path);
+}
+
+[[nodiscard]] static const EncoderProfile* get_encoder_profile(const LoadOptions* load_options, TextureRole role) {
+    const std::optional<EncoderProfile>* role_profile = &load_options->data_encoder_profile;
+    if (role == TextureRole::normal) {
+        role_profile = &load_options->normal_encoder_profile;
+    } else if (role == TextureRole::color) {
+        role_profile = &load_options->color_encoder_profile;
+    }
+
+    return role_profile->has_value() ? &role_profile->value() : &load_options->encoder_profile;
+}
+
+// compress ktx_texture with the job's encoder profile. uastc textures are zstd supercompressed, and inflated again by the transcoder
+static void encode_basis_texture(const ImageLoadJob* job, ktxTexture2* ktx_texture, uint32_t encoder_thread_count) {
+    const EncoderProfile* profile = &job->encoder_profile;
+
+    ktxBasisParams params{};
+    params.structSize  = sizeof(params);
+    params.threadCount = encoder_thread_count;
+    params.normalMap   = job->layout.normal_map;
+    if (profile->codec == BasisCodec::etc1s) {
+        params.uastc            = KTX_FALSE;
+        params.compressionLevel = profile->etc1s_compression_level;
+        params.qualityLevel     = profile->etc1s_quality_level;
+    } else {
+        params.uastc      = KTX_TRUE;
+        params.uastcFlags = std::min(profile->uastc_quality_level, static_cast<uint32_t>(KTX_PACK_UASTC_LEVEL_VERYSLOW));
+        if (profile->uastc_rdo_lambda > 0) {
+            params.uastcRDO              = KTX_TRUE;
+            params.uastcRDOQualityScalar = profile->uastc_rdo_lambda;
         }
     }
 
-    std::vector<GltfImage> gltf_images;
-    gltf_images.reserve(cgltf_data->images_count);
-    for (uint32_t i = 0; i < cgltf_data->images_count; i++) {
-#ifndef NDEBUG
-        std::cout << "loading GLTF image: " << std::to_string(i) << std::endl;
-#endif
+    KTX_error_code result = ktxTexture2_CompressBasisEx(ktx_texture, &params);
+    if (result != KTX_SUCCESS) {
+        const std::string message = "Cannot compress with error code: " + std::to_string(result);
+        abort_message(message);
+    }
+    if (profile->codec == BasisCodec::uastc && profile->zstd_level > 0) {
+        result = ktxTexture2_DeflateZstd(ktx_texture, profile->zstd_level);
+        if (result != KTX_SUCCESS) {
+            const std::string message = "Cannot supercompress with error code: " + std::to_string(result);
+            abort_message(message);
+        }
+    }
+}
 
-        // 1. pull formats from images
-        int width, height, component_count;
-        // todo: until i figure out the best way to deal with textures with different num of components in shaders, require 4
-        constexpr int required_components = 4;
+// compress job->ktx_texture and optionally write the result to the source cache tier
+static void compress_ktx_texture(ImageLoadJob* job, uint32_t encoder_thread_count, bool write_to_cache) {
+    encode_basis_texture(job, job->ktx_texture, encoder_thread_count);
+    if (write_to_cache) {
+        write_ktx_to_cache(job->ktx_texture, job->source_cache_path);
+    }
+}
 
-        const cgltf_buffer_view* buffer_view;
-        std::string              uri;
+// transcode to the device format and optionally write the result to the transcoded cache tier. textures loaded from the transcoded tier are
+// already in their final format
+static void transcode_ktx_texture(ImageLoadJob* job, bool write_to_cache) {
+    if (ktxTexture2_NeedsTranscoding(job->ktx_texture)) {
+        KTX_error_code result = ktxTexture2_TranscodeBasis(job->ktx_texture, job->ktx_transcode_format, 0);
+        if (result != KTX_SUCCESS) {
+            const std::string message = "Cannot transcode with error code: " + std::to_string(result);
+            abort_message(message);
+        }
+        if (write_to_cache) {
+            write_ktx_to_cache(job->ktx_texture, job->transcoded_cache_path);
+        }
+    }
+}
 
-        if (cgltf_data->file_type == cgltf_file_type_glb) {
-            buffer_view = cgltf_data->images[i].buffer_view;
-            stbi_info_from_memory(static_cast<uint8_t*>(buffer_view->buffer->data) + buffer_view->offset, static_cast<int>(buffer_view->size), &width,
-                                  &height, &component_count);
-        } else {
-            uri = load_options->gltf_path.parent_path().string() + "/" + cgltf_data->images[i].uri;
-            stbi_info(uri.c_str(), &width, &height, &component_count);
-        }
-
-        ktx_transcode_fmt_e ktx_transcode_format{};
-        VkFormat            uncompressed_format{};
-        VkFormat            compressed_format{}; // may not need this
-        get_format_for_image(cgltf_data, i, required_components, &uncompressed_format, &compressed_format, &ktx_transcode_format);
-
-        ktxTexture2*   ktx_texture = nullptr;
-        KTX_error_code result;
-
-        // 2. look into cache for images, if the cache directory exists
-        uint32_t mip_levels = 1;
-        if (load_options->create_mipmaps) {
-            mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
-        }
-        // hash is the [gltf asset name]_[image index]_[mip levels].ktx2
-        std::string image_hash = load_options->gltf_path.stem().string() + "_" + std::to_string(i) + "_" + std::to_string(mip_levels) + ".ktx2";
-        std::string cache_path = load_options->cache_dir.string() + image_hash;
-
-        bool cache_img_exists = false;
-        if (check_cache) {
-            if (std::filesystem::exists(cache_path)) {
-                cache_img_exists = true;
-                result           = ktxTexture2_CreateFromNamedFile(cache_path.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &ktx_texture);
-                if (result != KTX_SUCCESS) {
-                    const std::string message = "Cannot load file with error code: " + std::to_string(result);
-                    abort_message(message);
-                }
-            }
+// copy the streamed tail of job->ktx_texture into job->tail_ktx_texture, then encode and transcode it. the tail is small and never cached,
+// so it is ready long before the full chain
+static void encode_tail_texture(ImageLoadJob* job, uint32_t encoder_thread_count) {
+    create_ktx_texture(job, job->stream_first_level, &job->tail_ktx_texture);
+    for (uint32_t level = 0; level < job->tail_ktx_texture->numLevels; level++) {
+        size_t         src_offset;
+        size_t         dst_offset;
+        KTX_error_code result = ktxTexture2_GetImageOffset(job->ktx_texture, job->stream_first_level + level, 0, 0, &src_offset);
+        if (result == KTX_SUCCESS) {
+            result = ktxTexture2_GetImageOffset(job->tail_ktx_texture, level, 0, 0, &dst_offset);
         }
+        if (result != KTX_SUCCESS) {
+            const std::string message = "Cannot get offset into ktx image error code: " + std::to_string(result);
+            abort_message(message);
+        }
+        memcpy(job->tail_ktx_texture->pData + dst_offset, job->ktx_texture->pData + src_offset,
+               ktxTexture_GetImageSize(ktxTexture(job->tail_ktx_texture), level));
+    }
 
-        // 3. if caller didn't provide a cache directory, or if the image was not found there, load and compress the image now
-        if (!cache_img_exists) {
-            uint8_t* img_data{};
-            if (cgltf_data->file_type == cgltf_file_type_glb) {
-                img_data = stbi_load_from_memory(static_cast<uint8_t*>(buffer_view->buffer->data) + buffer_view->offset,
-                                                 static_cast<int>(buffer_view->size), &width, &height, &component_count, required_components);
-            } else {
-                img_data = stbi_load(uri.c_str(), &width, &height, &component_count, required_components);
-            }
+    encode_basis_texture(job, job->tail_ktx_texture, encoder_thread_count);
+    KTX_error_code result = ktxTexture2_TranscodeBasis(job->tail_ktx_texture, job->ktx_transcode_format, 0);
+    if (result != KTX_SUCCESS) {
+        const std::string message = "Cannot transcode with error code: " + std::to_string(result);
+        abort_message(message);
+    }
+}
 
-            if (img_data == nullptr) {
-                abort_message(stbi_failure_reason());
-            }
+// fill kept_levels with the kept part of the job's mip chain, starting from the decoded image. the channels job->layout keeps are picked out
+// of the decoded image, and levels dropped from the top of the chain are only filtered through in temporary storage
+static void generate_kept_levels(ImageLoadJob* job, const MipLevel* kept_levels, uint32_t kept_level_count, uint32_t decoded_component_count,
+                                 MipFilter mip_filter) {
+    const TextureLayout layout         = job->layout;
+    const uint32_t      channel_count  = layout.channel_count;
+    const uint32_t      dropped_levels = job->dropped_levels;
+
+    std::vector<MipLevel> chain(dropped_levels + kept_level_count);
+    uint64_t              dropped_size = 0;
+    for (uint32_t level = 0; level < dropped_levels; level++) {
+        chain[level].width  = get_level_dimension(job->width, level);
+        chain[level].height = get_level_dimension(job->height, level);
+        dropped_size += static_cast<uint64_t>(chain[level].width) * chain[level].height * channel_count;
+    }
+    std::vector<uint8_t> dropped_data(dropped_size);
+    uint64_t             dropped_offset = 0;
+    for (uint32_t level = 0; level < dropped_levels; level++) {
+        chain[level].data = dropped_data.data() + dropped_offset;
+        dropped_offset += static_cast<uint64_t>(chain[level].width) * chain[level].height * channel_count;
+    }
+    for (uint32_t level = 0; level < kept_level_count; level++) {
+        chain[dropped_levels + level] = kept_levels[level];
+    }
 
-            ktxTextureCreateInfo create_info{};
-            create_info.vkFormat        = uncompressed_format;
-            create_info.baseDepth       = 1;
-            create_info.baseWidth       = width;
-            create_info.baseHeight      = height;
-            create_info.numDimensions   = 2;
-            create_info.numFaces        = 1;
-            create_info.numLayers       = 1;
-            create_info.numLevels       = mip_levels;
-            create_info.isArray         = false;
-            create_info.generateMipmaps = false;
-            result                      = ktxTexture2_Create(&create_info, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &ktx_texture);
-            if (result != KTX_SUCCESS) {
-                const std::string message = "Cannot create ktx texture with error code: " + std::to_string(result);
-                abort_message(message);
+    const uint64_t texel_count = static_cast<uint64_t>(job->width) * job->height;
+    if (channel_count == decoded_component_count) {
+        memcpy(chain[0].data, job->img_data, texel_count * channel_count);
+    } else {
+        for (uint64_t texel = 0; texel < texel_count; texel++) {
+            for (uint32_t c = 0; c < channel_count; c++) {
+                chain[0].data[texel * channel_count + c] = job->img_data[texel * decoded_component_count + layout.source_channels[c]];
             }
+        }
+    }
+    stbi_image_free(job->img_data);
+    job->img_data = nullptr;
 
-            if (load_options->create_mipmaps) {
-                // 1. allocate vulkan image with appropriate mip levels, extents, etx
-                // 2. make staging buffer large enough for all levels.
-                // 3. fill in staging buffer at offset 0 with raw stb image data
-                // 4. maybe free stb image data now
-                // 5. buffer->image copy from staging to first mip level of image
-                // 6. for each mip level:
-                //    6.a blit from last level to the next (start at i = 1);
-                //    6.b create buffer to image copy struct
-                // 7. perform image->buffer copy to get all blitted images into the staging buffer
-                // 8. do ktx setImageFromMemory at the correct staging buffer offsets for all mip levels
-
-                // 1. allocate vulkan image with appropriate mip levels, extents, etx
-                VkImageCreateInfo mipmapped_image_ci =
-                    vk_lib::image_create_info(VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
-                                              vk_lib::extent_3d(width, height), mip_levels);
-                VmaAllocationCreateInfo mipmapped_allocation_ci{};
-                mipmapped_allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
-                VkImage           mipmapped_image;
-                VmaAllocation     mipmapped_image_allocation;
-                VmaAllocationInfo mipmapped_image_allocation_info;
-                VK_CHECK(vmaCreateImage(allocator, &mipmapped_image_ci, &mipmapped_allocation_ci, &mipmapped_image, &mipmapped_image_allocation,
-                                        &mipmapped_image_allocation_info));
-                // 2. make staging buffer large enough for all levels.
-                uint64_t required_mip_buffer_size = 0;
-                {
-                    uint32_t mip_width  = width;
-                    uint32_t mip_height = height;
-                    for (uint32_t level = 0; level < mip_levels; level++) {
-                        required_mip_buffer_size += mip_width * mip_height * 4; // 4 color channels. each color channel is a byte
-                        if (mip_width > 1) {
-                            mip_width /= 2;
-                        }
-                        if (mip_height > 1) {
-                            mip_height /= 2;
-                        }
-                    }
-                }
-                if (staging_buffer->allocation_info.size < required_mip_buffer_size) {
-                    allocate_staging_buffer(allocator, required_mip_buffer_size, staging_buffer);
-                }
-                // 3. fill in staging buffer at offset 0 with raw stb image data
-                memcpy(staging_buffer->allocation_info.pMappedData, img_data, width * height * 4);
-                // 4. maybe free stb image data now
-                stbi_image_free(img_data);
-
-                // 5. buffer->image copy from staging to first mip level of image
-                vk_command_immediate_submit(device, command_pool, queue, [&](VkCommandBuffer cmd_buf) {
-                    // transition all mip levels to DST_OPTIMAL
-                    VkImageSubresourceRange     subresource_range   = vk_lib::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT, mip_levels);
-                    const VkImageMemoryBarrier2 copy_memory_barrier = vk_lib::image_memory_barrier_2(
-                        mipmapped_image, subresource_range, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-                    const VkDependencyInfo copy_dependency_info = vk_lib::dependency_info(&copy_memory_barrier, nullptr, nullptr);
-                    vkCmdPipelineBarrier2(cmd_buf, &copy_dependency_info);
-
-                    VkImageSubresourceLayers subresource_layers = vk_lib::image_subresource_layers(VK_IMAGE_ASPECT_COLOR_BIT);
-                    VkExtent3D               image_extent       = vk_lib::extent_3d(width, height);
-                    VkBufferImageCopy        buffer_image_copy  = vk_lib::buffer_image_copy(subresource_layers, image_extent);
-
-                    vkCmdCopyBufferToImage(cmd_buf, staging_buffer->buffer, mipmapped_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
-                                           &buffer_image_copy);
-                });
+    generate_mip_chain(chain.data(), static_cast<uint32_t>(chain.size()), channel_count, is_srgb_format(job->uncompressed_format), mip_filter);
+}
 
-                // 6. for each mip level:
-                std::vector<VkBufferImageCopy> buffer_copies{};
-                buffer_copies.reserve(mip_levels - 1); // since first image is already in the staging buffer
-                vk_command_immediate_submit(device, command_pool, queue, [&](VkCommandBuffer cmd_buf) {
-                    uint32_t mip_width     = width;
-                    uint32_t mip_height    = height;
-                    uint64_t buffer_offset = mip_width * mip_height * 4;
-                    for (uint32_t level = 1; level < mip_levels; level++) {
-                        VkImageSubresourceRange     subresource_range = vk_lib::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT, 1, level - 1);
-                        const VkImageMemoryBarrier2 convert_old_to_src_optimal_barrier = vk_lib::image_memory_barrier_2(
-                            mipmapped_image, subresource_range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-
-                        const VkDependencyInfo src_level_dependency_info =
-                            vk_lib::dependency_info(&convert_old_to_src_optimal_barrier, nullptr, nullptr);
-
-                        vkCmdPipelineBarrier2(cmd_buf, &src_level_dependency_info);
-
-                        // blit
-                        VkImageSubresourceLayers blit_src_subresource_layers = vk_lib::image_subresource_layers(VK_IMAGE_ASPECT_COLOR_BIT, level - 1);
-                        VkImageSubresourceLayers blit_dst_subresource_layers = vk_lib::image_subresource_layers(VK_IMAGE_ASPECT_COLOR_BIT, level);
-                        std::array               src_offsets                 = {vk_lib::offset_3d(), vk_lib::offset_3d(mip_width, mip_height, 1)};
-                        std::array               dst_offsets                 = {vk_lib::offset_3d(),
-                                                                                vk_lib::offset_3d(mip_width > 1 ? mip_width / 2 : 1, mip_height > 1 ? mip_height / 2 : 1, 1)};
-                        VkImageBlit              image_blit =
-                            vk_lib::image_blit(blit_src_subresource_layers, blit_dst_subresource_layers, src_offsets, dst_offsets);
-
-                        vkCmdBlitImage(cmd_buf, mipmapped_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mipmapped_image,
-                                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &image_blit, VK_FILTER_LINEAR);
-
-                        if (level == mip_levels - 1) {
-                            // if the destination mip is the last mip level, it won't enter this loop again after this.
-                            // this means we have to transition it to transfer source optimal here
-                            subresource_range = vk_lib::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT, 1, level);
-                            const VkImageMemoryBarrier2 convert_last_to_src_optimal_barrier = vk_lib::image_memory_barrier_2(
-                                mipmapped_image, subresource_range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-
-                            const VkDependencyInfo final_level_dependency_info =
-                                vk_lib::dependency_info(&convert_last_to_src_optimal_barrier, nullptr, nullptr);
-
-                            vkCmdPipelineBarrier2(cmd_buf, &final_level_dependency_info);
-                        }
-
-                        VkImageSubresourceLayers copy_subresource_layers = vk_lib::image_subresource_layers(VK_IMAGE_ASPECT_COLOR_BIT, level);
-                        VkExtent3D mip_extent = vk_lib::extent_3d(mip_width > 1 ? mip_width / 2 : 1, mip_height > 1 ? mip_height / 2 : 1);
-
-                        VkBufferImageCopy buffer_image_copy = vk_lib::buffer_image_copy(copy_subresource_layers, mip_extent, buffer_offset);
-
-                        buffer_copies.push_back(buffer_image_copy);
-
-                        if (mip_width > 1) {
-                            mip_width /= 2;
-                        }
-                        if (mip_height > 1) {
-                            mip_height /= 2;
-                        }
-
-                        buffer_offset += mip_width * mip_height * 4;
-                    }
+// generate the levels of job->ktx_texture in place
+static void fill_ktx_levels(ImageLoadJob* job, uint32_t decoded_component_count, MipFilter mip_filter) {
+    std::vector<MipLevel> levels(job->mip_levels);
+    for (uint32_t level = 0; level < job->mip_levels; level++) {
+        size_t         ktx_offset;
+        KTX_error_code result = ktxTexture2_GetImageOffset(job->ktx_texture, level, 0, 0, &ktx_offset);
+        if (result != KTX_SUCCESS) {
+            const std::string message = "Cannot get offset into ktx image error code: " + std::to_string(result);
+            abort_message(message);
+        }
+        levels[level].data   = job->ktx_texture->pData + ktx_offset;
+        levels[level].width  = get_level_dimension(job->width, job->dropped_levels + level);
+        levels[level].height = get_level_dimension(job->height, job->dropped_levels + level);
+    }
 
-                    // copy all image data into the CPU side staging buffer in order for ktx to compress
-                    vkCmdCopyImageToBuffer(cmd_buf, mipmapped_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging_buffer->buffer,
-                                           buffer_copies.size(), buffer_copies.data());
-                });
+    generate_kept_levels(job, levels.data(), job->mip_levels, decoded_component_count, mip_filter);
+}
+
+// lay out level_count levels of the decoded rgba image in job->level_data and generate them. with gpu mipmaps only the base level is built
+// here
+static void build_uncompressed_levels(ImageLoadJob* job, uint32_t level_count, MipFilter mip_filter) {
+    constexpr uint32_t channel_count = 4;
+
+    std::vector<MipLevel> levels(level_count);
+    uint64_t              data_size = 0;
+    for (uint32_t level = 0; level < level_count; level++) {
+        levels[level].width  = get_level_dimension(job->width, job->dropped_levels + level);
+        levels[level].height = get_level_dimension(job->height, job->dropped_levels + level);
+        data_size += static_cast<uint64_t>(levels[level].width) * levels[level].height * channel_count;
+    }
+    job->level_data.resize(data_size);
+
+    uint64_t level_offset = 0;
+    job->levels.resize(level_count);
+    for (uint32_t level = 0; level < level_count; level++) {
+        levels[level].data = job->level_data.data() + level_offset;
+
+        ImageLevelUpload* level_upload = &job->levels[level];
+        level_upload->data             = levels[level].data;
+        level_upload->size             = static_cast<uint64_t>(levels[level].width) * levels[level].height * channel_count;
+        level_upload->extent           = vk_lib::extent_3d(levels[level].width, levels[level].height);
+        level_offset += level_upload->size;
+    }
 
-                uint32_t mip_width     = width;
-                uint32_t mip_height    = height;
-                uint64_t buffer_offset = 0;
-                for (uint32_t level = 0; level < mip_levels; level++) {
-                    uint64_t       data_size = mip_width * mip_height * 4;
-                    const uint8_t* src_data  = static_cast<uint8_t*>(staging_buffer->allocation_info.pMappedData);
+    generate_kept_levels(job, levels.data(), level_count, channel_count, mip_filter);
+}
 
-                    result = ktxTexture_SetImageFromMemory(ktxTexture(ktx_texture), level, 0, 0, src_data + buffer_offset, data_size);
+// create the vulkan image and view for a texture in its final device format and stream all of its levels through the staging ring. the copies
+// are only recorded here. they are submitted once the ring fills up or the load finishes. when mip_levels is larger than the number of levels
+// given, the uploaded levels are left in transfer src layout for record_gpu_mip_chain to fill in the rest
+[[nodiscard]] static GltfImage upload_image(VkFormat format, VkExtent3D extent, const std::vector<ImageLevelUpload>& levels, uint32_t mip_levels,
+                                            VkComponentMapping components, LoaderContext* loader_context, LoadStats* load_stats) {
+    const bool gpu_mipmaps = mip_levels > levels.size();
 
-                    if (result != KTX_SUCCESS) {
-                        const std::string message = "Cannot set ktx image from memory with error code: " + std::to_string(result);
-                        abort_message(message);
-                    }
+    VkImageUsageFlags image_usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (gpu_mipmaps) {
+        image_usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+    VkImageCreateInfo       image_ci = vk_lib::image_create_info(format, image_usage, extent, mip_levels);
+    VmaAllocationCreateInfo texture_allocation_ci{};
+    texture_allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+    texture_allocation_ci.flags = VMA_ALLOCATION_CREATE_STRATEGY_MIN_MEMORY_BIT;
+
+    GltfImage new_texture{};
+    new_texture.extent     = extent;
+    new_texture.mip_levels = mip_levels;
+    VK_CHECK(vmaCreateImage(loader_context->allocator, &image_ci, &texture_allocation_ci, &new_texture.image, &new_texture.allocation,
+                            &new_texture.allocation_info));
+
+    // create image view
+    VkImageSubresourceRange subresource_range = vk_lib::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT, mip_levels);
+    VkImageViewCreateInfo   image_view_ci     = vk_lib::image_view_create_info(format, new_texture.image, &subresource_range);
+    image_view_ci.components                  = components;
+    vkCreateImageView(loader_context->device, &image_view_ci, nullptr, &new_texture.image_view);
+
+    new_texture.image_format = format;
+    new_texture.components   = components;
+
+    const VkImageLayout upload_layout = gpu_mipmaps ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    staging_ring_upload_image(loader_context->staging_ring, new_texture.image, format, levels, upload_layout);
+    for (const ImageLevelUpload& level : levels) {
+        load_stats->texture_bytes_uploaded += level.size;
+    }
 
-                    buffer_offset += data_size;
-                    if (mip_width > 1) {
-                        mip_width /= 2;
-                    }
-                    if (mip_height > 1) {
-                        mip_height /= 2;
-                    }
-                }
-                vmaDestroyImage(allocator, mipmapped_image, mipmapped_image_allocation);
+    new_texture.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-            } else {
-                uint64_t img_data_size = required_components * width * height;
-                result                 = ktxTexture_SetImageFromMemory(ktxTexture(ktx_texture), 0, 0, 0, img_data, img_data_size);
-                stbi_image_free(img_data);
-                if (result != KTX_SUCCESS) {
-                    const std::string message = "Cannot set ktx image from memory with error code: " + std::to_string(result);
-                    abort_message(message);
-                }
-            }
+    return new_texture;
+}
 
-            ktxBasisParams params{};
-            params.structSize  = sizeof(params);
-            params.uastc       = KTX_TRUE;
-            params.threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+// blit every level of image from the one above it, starting from the base level left in transfer src layout by upload_image, and transition
+// the whole chain to shader read only
+static void record_gpu_mip_chain(VkCommandBuffer cmd_buf, const GltfImage* image) {
+    const VkImageSubresourceRange mip_range   = vk_lib::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT, image->mip_levels - 1, 1);
+    const VkImageMemoryBarrier2   mip_barrier = vk_lib::image_memory_barrier_2(image->image, mip_range, VK_IMAGE_LAYOUT_UNDEFINED,
+                                                                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    const VkDependencyInfo        mip_dependency_info = vk_lib::dependency_info(&mip_barrier, nullptr, nullptr);
+    vkCmdPipelineBarrier2(cmd_buf, &mip_dependency_info);
+
+    uint32_t mip_width  = image->extent.width;
+    uint32_t mip_height = image->extent.height;
+    for (uint32_t level = 1; level < image->mip_levels; level++) {
+        const uint32_t dst_width  = mip_width > 1 ? mip_width / 2 : 1;
+        const uint32_t dst_height = mip_height > 1 ? mip_height / 2 : 1;
+
+        VkImageSubresourceLayers src_subresource_layers = vk_lib::image_subresource_layers(VK_IMAGE_ASPECT_COLOR_BIT, level - 1);
+        VkImageSubresourceLayers dst_subresource_layers = vk_lib::image_subresource_layers(VK_IMAGE_ASPECT_COLOR_BIT, level);
+        std::array               src_offsets            = {vk_lib::offset_3d(), vk_lib::offset_3d(mip_width, mip_height, 1)};
+        std::array               dst_offsets            = {vk_lib::offset_3d(), vk_lib::offset_3d(dst_width, dst_height, 1)};
+        VkImageBlit image_blit = vk_lib::image_blit(src_subresource_layers, dst_subresource_layers, src_offsets, dst_offsets);
+
+        vkCmdBlitImage(cmd_buf, image->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                       &image_blit, VK_FILTER_LINEAR);
+
+        // the level just written is the source of the next blit
+        const VkImageSubresourceRange level_range   = vk_lib::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT, 1, level);
+        const VkImageMemoryBarrier2   level_barrier = vk_lib::image_memory_barrier_2(image->image, level_range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                                                     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        const VkDependencyInfo        level_dependency_info = vk_lib::dependency_info(&level_barrier, nullptr, nullptr);
+        vkCmdPipelineBarrier2(cmd_buf, &level_dependency_info);
+
+        mip_width  = dst_width;
+        mip_height = dst_height;
+    }
 
-            result = ktxTexture2_CompressBasisEx(ktx_texture, &params);
-            if (result != KTX_SUCCESS) {
-                const std::string message = "Cannot compress with error code: " + std::to_string(result);
-                abort_message(message);
-            }
-            if (write_to_cache) {
-                // 4. write the ktx texture to the cache directory only if the user provided a directory and if the image wasn't found in the cache
-                result = ktxTexture2_WriteToNamedFile(ktx_texture, cache_path.c_str());
-                if (result != KTX_SUCCESS) {
-                    const std::string message = "Cannot write ktx data to file with error code: " + std::to_string(result);
-                    abort_message(message);
-                }
-            }
-        }
+    const VkImageSubresourceRange chain_range   = vk_lib::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT, image->mip_levels);
+    const VkImageMemoryBarrier2   chain_barrier = vk_lib::image_memory_barrier_2(image->image, chain_range, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                                                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    const VkDependencyInfo        chain_dependency_info = vk_lib::dependency_info(&chain_barrier, nullptr, nullptr);
+    vkCmdPipelineBarrier2(cmd_buf, &chain_dependency_info);
+}
 
-        // 5. now that I have a ktx texture, transcode it appropriately
-        if (ktxTexture2_NeedsTranscoding(ktx_texture)) {
-            result = ktxTexture2_TranscodeBasis(ktx_texture, ktx_transcode_format, 0);
-            if (result != KTX_SUCCESS) {
-                const std::string message = "Cannot transcode with error code: " + std::to_string(result);
-                abort_message(message);
-            }
+// upload the levels of ktx_texture from first_level on. earlier levels are dropped
+[[nodiscard]] static GltfImage upload_ktx_texture(ktxTexture2* ktx_texture, uint32_t first_level, VkComponentMapping components,
+                                                  LoaderContext* loader_context, LoadStats* load_stats) {
+    // describe where each mip level lives inside the ktx data
+    std::vector<ImageLevelUpload> levels;
+    levels.reserve(ktx_texture->numLevels - first_level);
+    for (uint32_t mip_level = first_level; mip_level < ktx_texture->numLevels; mip_level++) {
+        size_t         ktx_offset;
+        KTX_error_code result = ktxTexture2_GetImageOffset(ktx_texture, mip_level, 0, 0, &ktx_offset);
+        if (result != KTX_SUCCESS) {
+            const std::string message = "Cannot get offset into ktx image error code: " + std::to_string(result);
+            abort_message(message);
         }
 
-        static uint64_t total_texture_bytes_allocated = 0;
-        VkExtent3D      base_image_extent             = vk_lib::extent_3d(ktx_texture->baseWidth, ktx_texture->baseHeight);
-
-        total_texture_bytes_allocated += (base_image_extent.height * base_image_extent.width);
-        VkImageCreateInfo image_ci =
-            vk_lib::image_create_info(static_cast<VkFormat>(ktx_texture->vkFormat), VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                                      base_image_extent, ktx_texture->numLevels);
-        VmaAllocationCreateInfo texture_allocation_ci{};
-        texture_allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
-        texture_allocation_ci.flags = VMA_ALLOCATION_CREATE_STRATEGY_MIN_MEMORY_BIT;
-
-        GltfImage new_texture{};
-        new_texture.extent = base_image_extent;
-        VK_CHECK(
-            vmaCreateImage(allocator, &image_ci, &texture_allocation_ci, &new_texture.image, &new_texture.allocation, &new_texture.allocation_info));
-
-        // create image view
-        VkImageSubresourceRange subresource_range = vk_lib::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT, ktx_texture->numLevels);
-        VkImageViewCreateInfo   image_view_ci =
-            vk_lib::image_view_create_info(static_cast<VkFormat>(ktx_texture->vkFormat), new_texture.image, &subresource_range);
-        vkCreateImageView(device, &image_view_ci, nullptr, &new_texture.image_view);
-
-        new_texture.image_format = static_cast<VkFormat>(ktx_texture->vkFormat);
-
-        // 6. allocate additional memory in the staging buffer allocation if needed for this texture
-        if (staging_buffer->allocation_info.size < ktx_texture->dataSize) {
-            allocate_staging_buffer(allocator, ktx_texture->dataSize, staging_buffer);
-        }
-        // 7. fill staging buffer with all image levels
-        memcpy(staging_buffer->allocation_info.pMappedData, ktx_texture->pData, ktx_texture->dataSize);
-
-        // 8. create copy info for each mip level for our staging_buffer -> image copy
-        std::vector<VkBufferImageCopy> buffer_image_copies;
-        buffer_image_copies.reserve(ktx_texture->numLevels);
-        uint32_t mip_width  = width;
-        uint32_t mip_height = height;
-        for (uint32_t mip_level = 0; mip_level < ktx_texture->numLevels; mip_level++) {
-            size_t ktx_offset;
-            result = ktxTexture2_GetImageOffset(ktx_texture, mip_level, 0, 0, &ktx_offset);
-            if (result != KTX_SUCCESS) {
-                const std::string message = "Cannot get offset into ktx image error code: " + std::to_string(result);
-                abort_message(message);
-            }
+        ImageLevelUpload level{};
+        level.data   = ktx_texture->pData + ktx_offset;
+        level.size   = ktxTexture_GetImageSize(ktxTexture(ktx_texture), mip_level);
+        level.extent = vk_lib::extent_3d(std::max(ktx_texture->baseWidth >> mip_level, 1u), std::max(ktx_texture->baseHeight >> mip_level, 1u));
+        levels.push_back(level);
+    }
+
+    return upload_image(static_cast<VkFormat>(ktx_texture->vkFormat), levels[0].extent, levels, static_cast<uint32_t>(levels.size()), components,
+                        loader_context, load_stats);
+}
 
-            VkImageSubresourceLayers image_subresource = vk_lib::image_subresource_layers(VK_IMAGE_ASPECT_COLOR_BIT, mip_level);
-            VkExtent3D               image_extent      = vk_lib::extent_3d(mip_width, mip_height);
-            VkBufferImageCopy        buffer_image_copy = vk_lib::buffer_image_copy(image_subresource, image_extent, ktx_offset);
+// upload the kept levels of an encoded, transcoded or cached texture from kept level first_level on. streamed tails encoded on this load
+// come from job->tail_ktx_texture, which is freed once uploaded
+[[nodiscard]] static GltfImage upload_compressed_job(ImageLoadJob* job, uint32_t first_level, LoaderContext* loader_context,
+                                                     LoadStats* load_stats) {
+    const bool               second_channel_in_alpha = job->texture_target == TextureTarget::rgba8 && job->native_format == VK_FORMAT_UNDEFINED;
+    const VkComponentMapping components              = get_texture_components(&job->layout, second_channel_in_alpha);
+    // entries of ktx2 sources hold the full chain, other textures were encoded without the dropped levels
+    const uint32_t source_level = (job->ktx2_source ? job->dropped_levels : 0) + first_level;
+
+    GltfImage image{};
+    if (first_level > 0 && job->tail_ktx_texture) {
+        image = upload_ktx_texture(job->tail_ktx_texture, 0, components, loader_context, load_stats);
+        ktxTexture2_Destroy(job->tail_ktx_texture);
+        job->tail_ktx_texture = nullptr;
+    } else if (job->cache_tier == CacheTier::transcoded) {
+        // levels are copied from the mapping into the staging ring while recording
+        const std::vector<ImageLevelUpload> levels(job->cached_image.levels.begin() + source_level, job->cached_image.levels.end());
+        image = upload_image(job->cached_image.format, levels[0].extent, levels, static_cast<uint32_t>(levels.size()), components, loader_context,
+                             load_stats);
+    } else {
+        image = upload_ktx_texture(job->ktx_texture, source_level, components, loader_context, load_stats);
+    }
+    image.target         = job->texture_target;
+    image.usage          = job->usage;
+    image.lod_bias       = job->dropped_levels + first_level;
+    image.fully_resident = first_level == 0;
 
-            buffer_image_copies.push_back(buffer_image_copy);
-            if (mip_width > 1) {
-                mip_width /= 2;
-            }
-            if (mip_height > 1) {
-                mip_height /= 2;
-            }
+    return image;
+}
+
+static void destroy_image(const LoaderContext* loader_context, const GltfImage* image) {
+    vkDestroyImageView(loader_context->device, image->image_view, nullptr);
+    vmaDestroyImage(loader_context->allocator, image->image, image->allocation);
+}
+
+// share a fully resident image with later loads under key. the image index it was loaded for holds the first reference
+static void register_shared_image(LoaderContext* loader_context, uint64_t share_key, GltfImage* image) {
+    SharedImage shared_image{};
+    shared_image.image           = *image;
+    shared_image.image.share_key = share_key;
+    shared_image.ref_count       = 1;
+    if (loader_context->shared_images.try_emplace(share_key, shared_image).second) {
+        image->share_key = share_key;
+    }
+}
+
+// free the texture data a job holds once its full chain is recorded, or streaming is stopped
+static void release_compressed_job(ImageLoadJob* job) {
+    mapped_file_close(&job->cached_file);
+    if (job->ktx_texture) {
+        ktxTexture2_Destroy(job->ktx_texture);
+        job->ktx_texture = nullptr;
+    }
+    if (job->tail_ktx_texture) {
+        ktxTexture2_Destroy(job->tail_ktx_texture);
+        job->tail_ktx_texture = nullptr;
+    }
+}
+
+[[nodiscard]] static VkFormat get_texture_target_format(TextureTarget texture_target) {
+    switch (texture_target) {
+    case TextureTarget::bc7:
+        return VK_FORMAT_BC7_UNORM_BLOCK;
+    case TextureTarget::bc5:
+        return VK_FORMAT_BC5_UNORM_BLOCK;
+    case TextureTarget::bc4:
+        return VK_FORMAT_BC4_UNORM_BLOCK;
+    case TextureTarget::astc_4x4:
+        return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+    case TextureTarget::etc2_rgba:
+        return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+    case TextureTarget::eac_rg11:
+        return VK_FORMAT_EAC_R11G11_UNORM_BLOCK;
+    case TextureTarget::eac_r11:
+        return VK_FORMAT_EAC_R11_UNORM_BLOCK;
+    case TextureTarget::rgba8:
+    default:
+        return VK_FORMAT_R8G8B8A8_UNORM;
+    }
+}
+
+// most top levels that can be dropped from an image. ktx2 sources can only drop the levels they ship with, other images can be downsampled to 1x1
+[[nodiscard]] static uint32_t get_max_dropped_levels(const ImageLoadJob* job) {
+    if (job->ktx2_source) {
+        return std::max(job->mip_levels, 1u) - 1;
+    }
+    return static_cast<uint32_t>(std::floor(std::log2(std::max(job->width, job->height))));
+}
+
+// device memory a texture takes up with dropped_levels top levels dropped. job->mip_levels still holds the level count of the full chain.
+// formats without block info are rejected when jobs are set up, and count as 0 here rather than failing the load
+[[nodiscard]] static uint64_t get_texture_size(const ImageLoadJob* job, uint32_t dropped_levels) {
+    // ktx2 sources that need no transcoding take up the size of their own format
+    const VkFormat format = job->native_format != VK_FORMAT_UNDEFINED ? job->native_format : get_texture_target_format(job->texture_target);
+
+    FormatBlockInfo block_info;
+    if (!find_format_block_info(format, &block_info)) {
+        return 0;
+    }
+    const uint32_t level_count = job->mip_levels <= 1 ? 1 : job->mip_levels - dropped_levels;
+
+    uint64_t size = 0;
+    for (uint32_t level = dropped_levels; level < dropped_levels + level_count; level++) {
+        const uint64_t blocks_wide = (get_level_dimension(job->width, level) + block_info.width - 1) / block_info.width;
+        const uint64_t blocks_high = (get_level_dimension(job->height, level) + block_info.height - 1) / block_info.height;
+        size += blocks_wide * blocks_high * block_info.bytes;
+    }
+    return size;
+}
+
+// free space of the device local heaps, as reported by the memory budget extension
+[[nodiscard]] static uint64_t get_free_device_memory(VmaAllocator allocator) {
+    const VkPhysicalDeviceMemoryProperties* memory_properties;
+    vmaGetMemoryProperties(allocator, &memory_properties);
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(allocator, budgets);
+
+    uint64_t free_memory = 0;
+    for (uint32_t heap = 0; heap < memory_properties->memoryHeapCount; heap++) {
+        if ((memory_properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && budgets[heap].budget > budgets[heap].usage) {
+            free_memory += budgets[heap].budget - budgets[heap].usage;
+        }
+    }
+    return free_memory;
+}
+
+// pick how many top levels every image drops. images larger than the max dimension of their role drop levels until they fit, then the
+// currently largest texture drops its top level until all of them fit the texture budget. mip_levels is set to the level count that is kept.
+// texture sizes are only computed when there is a budget to fit
+static void apply_texture_budget(const LoadOptions* load_options, std::vector<ImageLoadJob>& jobs, VmaAllocator allocator) {
+    uint64_t texture_budget = load_options->texture_budget;
+    if (load_options->texture_budget_from_heaps) {
+        texture_budget = get_free_device_memory(allocator);
+    }
+
+    uint64_t                                           total_size = 0;
+    std::priority_queue<std::pair<uint64_t, uint32_t>> largest_textures;
+    for (uint32_t i = 0; i < jobs.size(); i++) {
+        ImageLoadJob* job = &jobs[i];
+        if (job->skip) {
+            continue;
+        }
+
+        uint32_t max_dimension = load_options->max_data_dimension;
+        if (job->role == TextureRole::color) {
+            max_dimension = load_options->max_color_dimension;
+        } else if (job->role == TextureRole::normal) {
+            max_dimension = load_options->max_normal_dimension;
+        }
+        const uint32_t max_dropped_levels = get_max_dropped_levels(job);
+        const int      base_dimension     = std::max(job->width, job->height);
+        while (max_dimension != 0 && job->dropped_levels < max_dropped_levels &&
+               get_level_dimension(base_dimension, job->dropped_levels) > max_dimension) {
+            job->dropped_levels++;
+        }
+
+        if (texture_budget == 0) {
+            continue;
+        }
+        const uint64_t size = get_texture_size(job, job->dropped_levels);
+        total_size += size;
+        if (job->dropped_levels < max_dropped_levels) {
+            largest_textures.emplace(size, i);
+        }
+    }
+
+    while (total_size > texture_budget && !largest_textures.empty()) {
+        ImageLoadJob* job = &jobs[largest_textures.top().second];
+        largest_textures.pop();
+
+        const uint64_t size = get_texture_size(job, job->dropped_levels + 1);
+        total_size -= get_texture_size(job, job->dropped_levels) - size;
+        job->dropped_levels++;
+        if (job->dropped_levels < get_max_dropped_levels(job)) {
+            largest_textures.emplace(size, static_cast<uint32_t>(job - jobs.data()));
+        }
+    }
+
+    for (ImageLoadJob& job : jobs) {
+        if (job.mip_levels > 1) {
+            job.mip_levels -= job.dropped_levels;
+        }
+    }
+}
+
+// a full chain whose upload has been recorded. it replaces the streamed tail once the staging ring has passed ring_position
+struct StreamedUpload {
+    uint32_t  image_index{};
+    GltfImage image{};
+    uint64_t  ring_position{};
+};
+
+// background state of a load with LoadOptions::stream_textures. owns the jobs of every image and the pool still encoding full chains
+struct TextureStreamer {
+    WorkerPool*               worker_pool{};
+    std::vector<ImageLoadJob> jobs{};
+    // images whose full chain has not been recorded yet, in image order
+    std::vector<uint32_t> pending_images{};
+    // in ring position order
+    std::vector<StreamedUpload> uploads{};
+    uint64_t                    upload_budget{};
+    // full chain encodes check this before they start, so stopping does not wait for encodes nobody needs anymore
+    std::atomic<bool> cancelled{false};
+};
+
+// progress and cancellation shared by an asynchronous load and the threads polling it. synchronous loads have none
+struct LoadTracker {
+    std::atomic<LoadStage> stage{LoadStage::parsing};
+    std::atomic<uint32_t>  images_loaded{};
+    std::atomic<uint32_t>  image_count{};
+    std::atomic<uint32_t>  meshes_loaded{};
+    std::atomic<uint32_t>  mesh_count{};
+    std::atomic<uint64_t>  bytes_uploaded{};
+    std::atomic<bool>      cancelled{false};
+};
+
+[[nodiscard]] static bool is_load_cancelled(const LoadTracker* load_tracker) { return load_tracker && load_tracker->cancelled.load(); }
+
+static void set_load_stage(LoadTracker* load_tracker, LoadStage stage) {
+    if (load_tracker) {
+        load_tracker->stage = stage;
+    }
+}
+
+static void report_bytes_uploaded(LoadTracker* load_tracker, const LoadStats* load_stats) {
+    if (load_tracker) {
+        load_tracker->bytes_uploaded = load_stats->texture_bytes_uploaded + load_stats->geometry_bytes_uploaded;
+    }
+}
+
+// load gltf images, compress them, then create vulkan images and images views from them.
+// decoding, mipmap generation, compression and transcoding of all images run as jobs on a worker pool. only uploads run on the calling thread,
+// since it owns the loader context
+// with LoadOptions::stream_textures, images with levels above the streamed tail only get their tail uploaded here, and texture_streamer is
+// set to the streamer that uploads the rest. otherwise it is left null. a cancelled load returns only the images uploaded before it noticed.
+// when the streamer does not keep the worker pool busy, idle_worker_pool is set to it for the rest of the load, which then destroys it
+[[nodiscard]] static std::vector<GltfImage> load_gltf_images(const LoadOptions* load_options, const cgltf_data* cgltf_data,
+                                                             const LoadSelection* selection, LoaderContext* loader_context, LoadStats* load_stats,
+                                                             TextureStreamer** texture_streamer, WorkerPool** idle_worker_pool,
+                                                             LoadTracker* load_tracker) {
+    bool check_cache    = false;
+    bool write_to_cache = false;
+    if (!load_options->cache_dir.empty()) {
+        if (std::filesystem::exists(load_options->cache_dir)) {
+            check_cache    = true;
+            write_to_cache = true;
+        } else {
+            // will write to cache only if caller provided a cache directory and the image was not found in the cache
+            write_to_cache = std::filesystem::create_directory(load_options->cache_dir);
+        }
+    }
+
+    // images are always decoded to rgba. the channels each texture keeps are picked out of that by fill_ktx_levels
+    constexpr int required_components = 4;
+
+    WorkerPool* worker_pool = worker_pool_create(load_options->thread_count);
+
+    const bool         stream_textures = load_options->stream_textures && load_options->texture_mode == TextureMode::compressed;
+    TextureStreamer*   streamer        = stream_textures ? new TextureStreamer{} : nullptr;
+    std::atomic<bool>* cancelled       = stream_textures ? &streamer->cancelled : nullptr;
+
+    // 1. read and hash the encoded bytes of every image in parallel. external images are read into memory once here and decoded from there
+    const std::vector<bool>   fallback_only_images = get_fallback_only_images(cgltf_data);
+    std::vector<ImageLoadJob> jobs(selection->images.kept.size());
+    for (uint32_t i = 0; i < jobs.size(); i++) {
+        ImageLoadJob* job = &jobs[i];
+        job->image_index  = i;
+        job->gltf_index   = selection->images.kept[i];
+        if (fallback_only_images[job->gltf_index]) {
+            job->skip = true;
+            continue;
+        }
+
+        const cgltf_image* gltf_image = &cgltf_data->images[job->gltf_index];
+        if (cgltf_data->file_type == cgltf_file_type_glb) {
+            const cgltf_buffer_view* buffer_view = gltf_image->buffer_view;
+            job->encoded_data                    = static_cast<uint8_t*>(buffer_view->buffer->data) + buffer_view->offset;
+            job->encoded_size                    = buffer_view->size;
+        } else {
+            job->uri = load_options->gltf_path.parent_path().string() + "/" + gltf_image->uri;
+        }
+        job->ready = worker_pool_submit(worker_pool, [job] { read_encoded_image(job); });
+    }
+
+    // classify images while the reads are in flight
+    const std::vector<uint32_t> image_usages = get_image_usages(cgltf_data, selection);
+
+    // 2. gather formats, sizes and cache state for every image. this is cheap and lets the jobs below run without touching cgltf
+    VmaAllocatorInfo allocator_info;
+    vmaGetAllocatorInfo(loader_context->allocator, &allocator_info);
+    const VkPhysicalDevice physical_device = allocator_info.physicalDevice;
+
+    uint32_t encode_count = 0;
+    for (ImageLoadJob& job : jobs) {
+        if (job.skip) {
+            continue;
+        }
+        job.ready.get();
+
+        job.usage       = image_usages[job.gltf_index];
+        job.layout      = get_texture_layout(job.usage);
+        job.role        = get_texture_role(job.usage, &job.layout);
+        job.ktx2_source = is_ktx2_data(job.encoded_data, job.encoded_size);
+        if (job.ktx2_source) {
+            // only the header is read here. the levels, and whatever mips the file has, are loaded by the job
+            ktxTexture2*   header_texture;
+            KTX_error_code result = ktxTexture2_CreateFromMemory(job.encoded_data, job.encoded_size, KTX_TEXTURE_CREATE_NO_FLAGS, &header_texture);
+            if (result != KTX_SUCCESS) {
+                const std::string message = "Cannot read ktx2 image header with error code: " + std::to_string(result);
+                abort_message(message);
+            }
+            job.width      = static_cast<int>(header_texture->baseWidth);
+            job.height     = static_cast<int>(header_texture->baseHeight);
+            job.mip_levels = header_texture->numLevels;
+            // files that are not basis encoded are uploaded in their own format, so it has to be one the loader knows the block size of and
+            // the device supports. anything else is rejected here, before the format reaches sizing or upload
+            if (!ktxTexture2_NeedsTranscoding(header_texture)) {
+                job.native_format = static_cast<VkFormat>(header_texture->vkFormat);
+                FormatBlockInfo block_info;
+                if (!find_format_block_info(job.native_format, &block_info)) {
+                    abort_message(std::string("ktx2 image format cannot be loaded: ") + string_VkFormat(job.native_format));
+                }
+                if (!is_texture_format_supported(physical_device, job.native_format)) {
+                    abort_message(std::string("ktx2 image format is not supported by the device: ") + string_VkFormat(job.native_format));
+                }
+            }
+            // the channels were packed offline. they are trusted to be the ones the material slots read when their count matches the
+            // layout picked above, otherwise the texture is treated as a plain 4 channel texture
+            if (ktxTexture2_GetNumComponents(header_texture) != job.layout.channel_count) {
+                job.layout = TextureLayout{};
+            }
+            ktxTexture2_Destroy(header_texture);
+        } else {
+            int component_count;
+            stbi_info_from_memory(job.encoded_data, static_cast<int>(job.encoded_size), &job.width, &job.height, &component_count);
+            if (load_options->create_mipmaps) {
+                job.mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(job.width, job.height)))) + 1;
+            }
+        }
+
+        if (load_options->texture_mode == TextureMode::uncompressed && !job.ktx2_source) {
+            // uploaded as decoded, so every image keeps all four channels and nothing goes through the cache
+            const bool srgb         = job.layout.srgb;
+            job.uncompressed        = true;
+            job.layout              = TextureLayout{};
+            job.layout.srgb         = srgb;
+            job.uncompressed_format = get_uncompressed_format(&job.layout);
+            job.texture_target      = TextureTarget::rgba8;
+            continue;
+        }
+
+        job.encoder_profile     = *get_encoder_profile(load_options, job.role);
+        job.uncompressed_format = get_uncompressed_format(&job.layout);
+        if (job.native_format != VK_FORMAT_UNDEFINED) {
+            job.texture_target = get_format_texture_target(job.native_format);
+        } else {
+            choose_texture_target(&loader_context->format_support, job.layout.channel_count, &job.texture_target, &job.ktx_transcode_format);
+        }
+    }
+
+    // images with the same bytes that are loaded the same way are only loaded once per asset. later ones share the first one's GltfImage
+    std::unordered_map<uint64_t, uint32_t> first_images;
+    for (ImageLoadJob& job : jobs) {
+        if (job.skip) {
+            continue;
+        }
+        const uint64_t duplicate_params[] = {job.content_hash,
+                                             job.uncompressed,
+                                             job.ktx2_source,
+                                             static_cast<uint64_t>(job.role),
+                                             static_cast<uint64_t>(job.uncompressed_format),
+                                             job.layout.source_channels[0],
+                                             job.layout.source_channels[1],
+                                             job.layout.normal_map};
+
+        const auto [first_image, inserted] = first_images.try_emplace(hash_64(duplicate_params, sizeof(duplicate_params)), job.image_index);
+        if (!inserted) {
+            job.duplicate_of = first_image->second;
+            job.skip         = true;
+            job.file_data    = {};
+            job.encoded_data = nullptr;
+            job.encoded_size = 0;
+        }
+    }
+
+    // every texture size is known now, so the top levels that don't fit the budget can be dropped before anything is encoded
+    apply_texture_budget(load_options, jobs, loader_context->allocator);
+
+    // look up the shared and cache state of every image now that its final size is known
+    for (ImageLoadJob& job : jobs) {
+        if (job.skip) {
+            continue;
+        }
+
+        // cache entries are named after the image contents and everything that affects encoding them, so identical images are shared across
+        // assets and edited images never hit a stale entry. ktx2 sources always cache their full chain, and drop levels when uploading
+        const EncoderProfile* profile         = &job.encoder_profile;
+        uint32_t              rdo_lambda_bits = 0;
+        memcpy(&rdo_lambda_bits, &profile->uastc_rdo_lambda, sizeof(rdo_lambda_bits));
+        const uint64_t encode_params[] = {job.content_hash,
+                                          texture_cache_version,
+                                          static_cast<uint64_t>(job.uncompressed_format),
+                                          job.ktx2_source ? 0 : job.mip_levels,
+                                          job.ktx2_source ? 0 : job.dropped_levels,
+                                          static_cast<uint64_t>(load_options->mip_filter),
+                                          required_components,
+                                          job.layout.source_channels[0],
+                                          job.layout.source_channels[1],
+                                          job.layout.normal_map,
+                                          job.ktx2_source,
+                                          static_cast<uint64_t>(profile->codec),
+                                          profile->etc1s_compression_level,
+                                          profile->etc1s_quality_level,
+                                          profile->uastc_quality_level,
+                                          rdo_lambda_bits,
+                                          profile->zstd_level};
+        const uint64_t cache_key       = hash_64(encode_params, sizeof(encode_params));
+
+        // images loaded by earlier loads are reused when they match everything the cache key covers and were loaded to the same levels and
+        // device format
+        const uint64_t share_params[] = {cache_key,
+                                         job.uncompressed,
+                                         job.uncompressed && load_options->gpu_mipmaps,
+                                         job.mip_levels,
+                                         job.dropped_levels,
+                                         static_cast<uint64_t>(job.ktx_transcode_format)};
+        job.share_key                 = hash_64(share_params, sizeof(share_params));
+        if (loader_context->shared_images.contains(job.share_key)) {
+            job.shared       = true;
+            job.skip         = true;
+            job.file_data    = {};
+            job.encoded_data = nullptr;
+            job.encoded_size = 0;
+            continue;
+        }
+        if (job.uncompressed) {
+            continue;
+        }
+        if (stream_textures) {
+            // the tail starts at the first kept level that fits the tail dimension, and always has at least the last level
+            while (job.stream_first_level + 1 < job.mip_levels &&
+                   std::max(get_level_dimension(job.width, job.dropped_levels + job.stream_first_level),
+                            get_level_dimension(job.height, job.dropped_levels + job.stream_first_level)) > load_options->streaming_tail_dimension) {
+                job.stream_first_level++;
+            }
+        }
+
+        char cache_name[48];
+        snprintf(cache_name, sizeof(cache_name), "%016llx.ktx2", static_cast<unsigned long long>(cache_key));
+        job.source_cache_path = (load_options->cache_dir / cache_name).string();
+        // the transcoded tier holds one entry per device format the source was transcoded to
+        snprintf(cache_name, sizeof(cache_name), "%016llx_%u.ktx2", static_cast<unsigned long long>(cache_key),
+                 static_cast<uint32_t>(job.ktx_transcode_format));
+        job.transcoded_cache_path = (load_options->cache_dir / cache_name).string();
+
+        // ktx2 sources are already what the source tier would hold, so they only use the transcoded tier
+        if (check_cache && std::filesystem::exists(job.transcoded_cache_path)) {
+            job.cache_tier = CacheTier::transcoded;
+        } else if (job.ktx2_source) {
+            // loaded straight from the encoded bytes
+        } else if (check_cache && std::filesystem::exists(job.source_cache_path)) {
+            job.cache_tier = CacheTier::source;
+        } else {
+            job.encodes_tail = job.stream_first_level > 0;
+            encode_count++;
+        }
+        if (job.cache_tier != CacheTier::none) {
+            job.file_data    = {};
+            job.encoded_data = nullptr;
+            job.encoded_size = 0;
+        }
+    }
+
+    // 3. split the thread budget between the pool and the basis encoder. when there are fewer images to encode than threads, each encode gets
+    // several threads so the machine stays busy without oversubscribing it
+    const uint32_t thread_budget        = worker_pool_thread_count(worker_pool);
+    const uint32_t encoder_thread_count = std::max(thread_budget / std::clamp(encode_count, 1u, thread_budget), 1u);
+
+    for (ImageLoadJob& job : jobs) {
+        ImageLoadJob* job_ptr = &job;
+        if (job.skip) {
+            continue;
+        }
+        if (job.uncompressed) {
+            const uint32_t  level_count = load_options->gpu_mipmaps ? 1 : job.mip_levels;
+            const MipFilter mip_filter  = load_options->mip_filter;
+            job.ready                   = worker_pool_submit(worker_pool, [job_ptr, level_count, mip_filter, load_tracker] {
+                if (is_load_cancelled(load_tracker)) {
+                    return;
+                }
+                decode_image(job_ptr, required_components);
+                build_uncompressed_levels(job_ptr, level_count, mip_filter);
+            });
+        } else if (job.cache_tier == CacheTier::transcoded) {
+            job.ready = worker_pool_submit(worker_pool, [job_ptr] { map_cached_texture(job_ptr); });
+        } else if (job.ktx2_source) {
+            job.ready = worker_pool_submit(worker_pool, [job_ptr, write_to_cache] {
+                load_ktx2_source(job_ptr);
+                transcode_ktx_texture(job_ptr, write_to_cache);
+            });
+        } else if (job.cache_tier == CacheTier::source) {
+            job.ready = worker_pool_submit(worker_pool, [job_ptr, write_to_cache] {
+                load_cached_ktx_texture(job_ptr);
+                transcode_ktx_texture(job_ptr, write_to_cache);
+            });
+        } else if (job.encodes_tail) {
+            // the full chain is queued behind the tails of most other images, so load_gltf only waits for the tails
+            const MipFilter mip_filter = load_options->mip_filter;
+            job.tail_ready = worker_pool_submit(worker_pool, [job_ptr, mip_filter, encoder_thread_count, write_to_cache, worker_pool, cancelled,
+                                                              load_tracker] {
+                if (is_load_cancelled(load_tracker)) {
+                    return;
+                }
+                decode_image(job_ptr, required_components);
+                create_ktx_texture(job_ptr, 0, &job_ptr->ktx_texture);
+                fill_ktx_levels(job_ptr, required_components, mip_filter);
+                encode_tail_texture(job_ptr, encoder_thread_count);
+                job_ptr->ready = worker_pool_submit(worker_pool, [job_ptr, encoder_thread_count, write_to_cache, cancelled] {
+                    if (cancelled->load()) {
+                        return;
+                    }
+                    compress_ktx_texture(job_ptr, encoder_thread_count, write_to_cache);
+                    transcode_ktx_texture(job_ptr, write_to_cache);
+                });
+            });
+        } else {
+            // mipmaps are generated on the cpu by the same job that encodes them, so a cold load needs no gpu work before the upload
+            const MipFilter mip_filter = load_options->mip_filter;
+            job.ready                  = worker_pool_submit(worker_pool, [job_ptr, mip_filter, encoder_thread_count, write_to_cache, load_tracker] {
+                if (is_load_cancelled(load_tracker)) {
+                    return;
+                }
+                decode_image(job_ptr, required_components);
+                create_ktx_texture(job_ptr, 0, &job_ptr->ktx_texture);
+                fill_ktx_levels(job_ptr, required_components, mip_filter);
+                compress_ktx_texture(job_ptr, encoder_thread_count, write_to_cache);
+                transcode_ktx_texture(job_ptr, write_to_cache);
+            });
+        }
+    }
+
+    // 4. single upload stage. consumes transcoded textures in image order while later images are still being encoded
+    std::vector<GltfImage> gltf_images;
+    std::vector<uint32_t>  gpu_mipmap_images;
+    gltf_images.reserve(jobs.size());
+    for (ImageLoadJob& job : jobs) {
+        if (job.skip) {
+            GltfImage image{};
+            if (job.duplicate_of.has_value()) {
+                image = gltf_images[job.duplicate_of.value()];
+            } else if (job.shared) {
+                image = loader_context->shared_images.at(job.share_key).image;
+            }
+            if (image.share_key != 0) {
+                loader_context->shared_images.at(image.share_key).ref_count++;
+            }
+            image.usage = job.usage;
+            gltf_images.push_back(image);
+            continue;
+        }
+        if (job.encodes_tail) {
+            job.tail_ready.wait();
+        } else {
+            job.ready.wait();
+        }
+        // checked after waiting, since jobs that start after the load is cancelled return without loading anything
+        if (is_load_cancelled(load_tracker)) {
+            break;
+        }
+#ifndef NDEBUG
+        std::cout << "uploading GLTF image: " << std::to_string(job.image_index) << std::endl;
+#endif
+        if (job.uncompressed) {
+            const VkComponentMapping components = get_texture_components(&job.layout, false);
+            const VkExtent3D         extent     =
+                vk_lib::extent_3d(get_level_dimension(job.width, job.dropped_levels), get_level_dimension(job.height, job.dropped_levels));
+            gltf_images.push_back(upload_image(job.uncompressed_format, extent, job.levels, job.mip_levels, components, loader_context, load_stats));
+            if (job.mip_levels > job.levels.size()) {
+                gpu_mipmap_images.push_back(job.image_index);
+            }
+            job.level_data = {};
+            job.levels     = {};
+
+            gltf_images.back().target   = job.texture_target;
+            gltf_images.back().usage    = job.usage;
+            gltf_images.back().lod_bias = job.dropped_levels;
+            register_shared_image(loader_context, job.share_key, &gltf_images.back());
+        } else {
+            // streamed images keep their texture data until poll_texture_streaming uploads the full chain. they are owned by the asset, since
+            // their GltfImage changes once they are upgraded
+            gltf_images.push_back(upload_compressed_job(&job, job.stream_first_level, loader_context, load_stats));
+            if (job.stream_first_level > 0) {
+                streamer->pending_images.push_back(job.image_index);
+            } else {
+                release_compressed_job(&job);
+                register_shared_image(loader_context, job.share_key, &gltf_images.back());
+            }
+        }
+
+        if (load_tracker) {
+            load_tracker->images_loaded++;
+            report_bytes_uploaded(load_tracker, load_stats);
+        }
+    }
+
+    if (is_load_cancelled(load_tracker)) {
+        // queued encodes return right away. whatever the finished ones hold is freed with the jobs that were never uploaded
+        if (streamer) {
+            streamer->cancelled = true;
+        }
+        worker_pool_destroy(worker_pool);
+        for (ImageLoadJob& job : jobs) {
+            release_compressed_job(&job);
+        }
+        delete streamer;
+        return gltf_images;
+    }
+
+    // the blits of every image are recorded after all uploads, so they are submitted together with the last uploads of the load
+    for (uint32_t image_index : gpu_mipmap_images) {
+        record_gpu_mip_chain(staging_ring_command_buffer(loader_context->staging_ring), &gltf_images[image_index]);
+    }
+
+    if (streamer && !streamer->pending_images.empty()) {
+        // the pool keeps encoding full chains after the load returns. moving the jobs keeps the addresses its queued jobs point to
+        streamer->worker_pool   = worker_pool;
+        streamer->jobs          = std::move(jobs);
+        streamer->upload_budget = load_options->streaming_upload_budget;
+        *texture_streamer       = streamer;
+    } else {
+        *idle_worker_pool = worker_pool;
+        delete streamer;
+    }
+
+    return gltf_images;
+}
+
+[[nodiscard]] static bool is_same_sampler(const VkSamplerCreateInfo* a, const VkSamplerCreateInfo* b) {
+    return a->flags == b->flags && a->magFilter == b->magFilter && a->minFilter == b->minFilter && a->mipmapMode == b->mipmapMode &&
+           a->addressModeU == b->addressModeU && a->addressModeV == b->addressModeV && a->addressModeW == b->addressModeW &&
+           a->mipLodBias == b->mipLodBias && a->anisotropyEnable == b->anisotropyEnable && a->maxAnisotropy == b->maxAnisotropy &&
+           a->compareEnable == b->compareEnable && a->compareOp == b->compareOp && a->minLod == b->minLod && a->maxLod == b->maxLod &&
+           a->borderColor == b->borderColor && a->unnormalizedCoordinates == b->unnormalizedCoordinates;
+}
+
+// scenes only use a handful of distinct samplers, so the cache is searched linearly
+[[nodiscard]] static std::optional<uint32_t> find_cached_sampler(const LoaderContext* loader_context, const VkSamplerCreateInfo* sampler_info) {
+    for (uint32_t i = 0; i < loader_context->samplers.size(); i++) {
+        const CachedSampler* cached_sampler = &loader_context->samplers[i];
+        if (cached_sampler->ref_count > 0 && is_same_sampler(&cached_sampler->create_info, sampler_info)) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+// store cached_sampler in the first free slot of the cache and return its index
+[[nodiscard]] static uint32_t insert_cached_sampler(LoaderContext* loader_context, const CachedSampler* cached_sampler) {
+    std::vector<CachedSampler>& samplers = loader_context->samplers;
+    for (uint32_t i = 0; i < samplers.size(); i++) {
+        if (samplers[i].ref_count == 0) {
+            samplers[i] = *cached_sampler;
+            return i;
+        }
+    }
+    samplers.push_back(*cached_sampler);
+    return static_cast<uint32_t>(samplers.size() - 1);
+}
+
+// return the index of a cached sampler created from sampler_info, creating it if no loaded asset uses one yet
+[[nodiscard]] static uint32_t acquire_sampler(LoaderContext* loader_context, const VkSamplerCreateInfo* sampler_info) {
+    const std::optional<uint32_t> sampler_index = find_cached_sampler(loader_context, sampler_info);
+    if (sampler_index.has_value()) {
+        loader_context->samplers[sampler_index.value()].ref_count++;
+        return sampler_index.value();
+    }
+
+    CachedSampler cached_sampler{};
+    cached_sampler.create_info = *sampler_info;
+    cached_sampler.ref_count   = 1;
+    VK_CHECK(vkCreateSampler(loader_context->device, sampler_info, nullptr, &cached_sampler.sampler));
+
+    return insert_cached_sampler(loader_context, &cached_sampler);
+}
+
+static void release_sampler(LoaderContext* loader_context, uint32_t sampler_index) {
+    CachedSampler* cached_sampler = &loader_context->samplers[sampler_index];
+    if (--cached_sampler->ref_count == 0) {
+        vkDestroySampler(loader_context->device, cached_sampler->sampler, nullptr);
+        *cached_sampler = {};
+    }
+}
+
+[[nodiscard]] static std::vector<uint32_t> load_gltf_samplers(const cgltf_data* cgltf_data, const LoadSelection* selection,
+                                                              LoaderContext* loader_context) {
+    std::vector<uint32_t> samplers;
+    samplers.reserve(selection->samplers.kept.size());
+
+    const float max_anisotropy = std::min(loader_context->max_sampler_anisotropy, loader_context->device_max_sampler_anisotropy);
+
+    for (uint32_t sampler_index : selection->samplers.kept) {
+        const cgltf_sampler* cgltf_sampler = &cgltf_data->samplers[sampler_index];
+
+        VkSamplerCreateInfo sampler_info = {};
+        sampler_info.sType               = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+
+        switch (cgltf_sampler->mag_filter) {
+        case cgltf_filter_type_nearest:
+        case cgltf_filter_type_nearest_mipmap_nearest:
+        case cgltf_filter_type_nearest_mipmap_linear:
+            sampler_info.magFilter = VK_FILTER_NEAREST;
+            break;
+        default:
+            sampler_info.magFilter = VK_FILTER_LINEAR;
+            break;
+        }
+
+        switch (cgltf_sampler->min_filter) {
+        case cgltf_filter_type_nearest:
+        case cgltf_filter_type_nearest_mipmap_nearest:
+            sampler_info.minFilter  = VK_FILTER_NEAREST;
+            sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            break;
+
+        case cgltf_filter_type_linear:
+        case cgltf_filter_type_linear_mipmap_nearest:
+            sampler_info.minFilter  = VK_FILTER_LINEAR;
+            sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+            break;
+
+        case cgltf_filter_type_nearest_mipmap_linear:
+            sampler_info.minFilter  = VK_FILTER_NEAREST;
+            sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            break;
+
+        default:
+            sampler_info.minFilter  = VK_FILTER_LINEAR;
+            sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+            break;
+        }
+
+        switch (cgltf_sampler->wrap_s) {
+        case cgltf_wrap_mode_clamp_to_edge:
+            sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            break;
+        case cgltf_wrap_mode_mirrored_repeat:
+            sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+            break;
+        default:
+            sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            break;
+        }
+
+        switch (cgltf_sampler->wrap_t) {
+        case cgltf_wrap_mode_clamp_to_edge:
+            sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+            break;
+
+        case cgltf_wrap_mode_mirrored_repeat:
+            sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
+            break;
+        default:
+            sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+            break;
+        }
+
+        sampler_info.addressModeW            = sampler_info.addressModeV; // Usually the same as V
+        sampler_info.anisotropyEnable        = max_anisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+        sampler_info.maxAnisotropy           = max_anisotropy > 1.0f ? max_anisotropy : 1.0f;
+        sampler_info.borderColor             = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+        sampler_info.unnormalizedCoordinates = VK_FALSE;
+        sampler_info.compareEnable           = VK_FALSE;
+        sampler_info.compareOp               = VK_COMPARE_OP_NEVER;
+        sampler_info.mipLodBias              = loader_context->sampler_lod_bias;
+        sampler_info.minLod                  = 0.0f;
+        sampler_info.maxLod                  = VK_LOD_CLAMP_NONE;
+
+        samplers.push_back(acquire_sampler(loader_context, &sampler_info));
+    }
+
+    return samplers;
+}
+
+// keeps every chunk of geometry data float aligned within the staging ring
+constexpr uint64_t geometry_staging_alignment = 16;
+
+static uint64_t get_primitive_vertex_count(const cgltf_primitive* gltf_primitive) {
+    size_t attribute_count = 0;
+    for (uint64_t k = 0; k < gltf_primitive->attributes_count; k++) {
+        attribute_count = std::max(attribute_count, gltf_primitive->attributes[k].data->count);
+    }
+    return attribute_count;
+}
+
+// dense uint16 and uint32 indices are uploaded as stored. uint8, strided and sparse indices are widened to uint32 first
+[[nodiscard]] static bool can_copy_indices(const cgltf_accessor* indices_accessor) {
+    const uint64_t component_byte_size = cgltf_component_size(indices_accessor->component_type);
+    return !indices_accessor->is_sparse && indices_accessor->buffer_view && indices_accessor->stride == component_byte_size &&
+           (indices_accessor->component_type == cgltf_component_type_r_16u || indices_accessor->component_type == cgltf_component_type_r_32u);
+}
+
+static uint64_t get_primitive_index_data_size(const cgltf_primitive* gltf_primitive) {
+    if (!gltf_primitive->indices) {
+        return 0;
+    }
+    const cgltf_accessor* indices_accessor    = gltf_primitive->indices;
+    const uint64_t        component_byte_size = can_copy_indices(indices_accessor) ? cgltf_component_size(indices_accessor->component_type) : 4;
+    return component_byte_size * indices_accessor->count;
+}
+
+// compute bounds from the min and max of the position accessor
+static void get_primitive_bounds(const cgltf_primitive* gltf_primitive, Bounds* bounds) {
+    for (uint32_t k = 0; k < gltf_primitive->attributes_count; k++) {
+        const cgltf_attribute* gltf_attribute = &gltf_primitive->attributes[k];
+        if (gltf_attribute->type != cgltf_attribute_type_position) {
+            continue;
+        }
+        const cgltf_accessor* position_accessor = gltf_attribute->data;
+
+        float min_pos[3], max_pos[3];
+        for (uint32_t axis = 0; axis < 3; axis++) {
+            min_pos[axis] = decode_accessor_bound(position_accessor, position_accessor->min[axis]);
+            max_pos[axis] = decode_accessor_bound(position_accessor, position_accessor->max[axis]);
+        }
+
+        bounds->origin[0] = (min_pos[0] + max_pos[0]) / 2.f;
+        bounds->origin[1] = (min_pos[1] + max_pos[1]) / 2.f;
+        bounds->origin[2] = (min_pos[2] + max_pos[2]) / 2.f;
+
+        bounds->extent[0] = (max_pos[0] - min_pos[0]) / 2.f;
+        bounds->extent[1] = (max_pos[1] - min_pos[1]) / 2.f;
+        bounds->extent[2] = (max_pos[2] - min_pos[2]) / 2.f;
+
+        float ex_0 = bounds->extent[0];
+        float ex_1 = bounds->extent[1];
+        float ex_2 = bounds->extent[2];
+
+        bounds->sphere_radius = sqrt((ex_0 * ex_0) + (ex_1 * ex_1) + (ex_2 * ex_2));
+    }
+}
+
+// fill vertex_arr with all per-vertex attributes of the vertices [first_vertex, first_vertex + vertex_count) of a primitive. attributes of any
+// component type are decoded to floats, so quantized and normalized accessors load like float ones. vertex_arr must hold default vertices,
+// which attributes the primitive lacks keep
+static void write_primitive_vertices(const cgltf_primitive* gltf_primitive, uint64_t first_vertex, uint64_t vertex_count, Vertex* vertex_arr) {
+    const uint64_t end_vertex = first_vertex + vertex_count;
+
+    // load all per-vertex attributes
+    for (uint32_t k = 0; k < gltf_primitive->attributes_count; k++) {
+        const cgltf_attribute* gltf_attribute = &gltf_primitive->attributes[k];
+        const cgltf_accessor*  accessor       = gltf_attribute->data;
+        if (first_vertex >= accessor->count) {
+            continue;
+        }
+        const uint64_t attribute_count = std::min(end_vertex, accessor->count) - first_vertex;
+
+        switch (gltf_attribute->type) {
+        case cgltf_attribute_type_position:
+            decode_accessor(accessor, first_vertex, attribute_count, 3, vertex_arr->position, sizeof(Vertex));
+            break;
+        case cgltf_attribute_type_normal:
+            decode_accessor(accessor, first_vertex, attribute_count, 3, vertex_arr->normal, sizeof(Vertex));
+            break;
+        case cgltf_attribute_type_tangent:
+            decode_accessor(accessor, first_vertex, attribute_count, 4, vertex_arr->tangent, sizeof(Vertex));
+            break;
+        case cgltf_attribute_type_texcoord: {
+            // only handling 2 texture coordinates per vertex for now
+            uint32_t tex_coord_idx;
+            if (strcmp(gltf_attribute->name, "TEXCOORD_0") == 0) {
+                tex_coord_idx = 0;
+            } else if (strcmp(gltf_attribute->name, "TEXCOORD_1") == 0) {
+                tex_coord_idx = 1;
+            } else {
+                break;
+            }
+            decode_accessor(accessor, first_vertex, attribute_count, 2, vertex_arr->tex_coord[tex_coord_idx], sizeof(Vertex));
+            break;
+        }
+        case cgltf_attribute_type_color:
+            decode_accessor(accessor, first_vertex, attribute_count, 4, vertex_arr->color, sizeof(Vertex));
+            if (accessor->type == cgltf_type_vec3) {
+                for (uint64_t color_idx = 0; color_idx < attribute_count; color_idx++) {
+                    vertex_arr[color_idx].color[3] = 1;
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+uint32_t get_vertex_size(VertexFormat vertex_format) {
+    switch (vertex_format) {
+    case VertexFormat::packed:
+        return sizeof(PackedVertex);
+    case VertexFormat::quantized:
+        return sizeof(QuantizedVertex);
+    default:
+        return sizeof(Vertex);
+    }
+}
+
+// round to the nearest half float, keeping infinities and nans
+[[nodiscard]] static uint16_t float_to_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign     = (bits >> 16) & 0x8000;
+    const uint32_t exponent = (bits >> 23) & 0xff;
+    uint32_t       mantissa = bits & 0x7fffff;
+
+    if (exponent == 0xff) {
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    }
+    const int32_t half_exponent = static_cast<int32_t>(exponent) - 127 + 15;
+    if (half_exponent >= 31) {
+        return sign | 0x7c00;
+    }
+    if (half_exponent <= 0) {
+        // subnormal half, or zero when even the implicit bit is shifted out
+        if (half_exponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        const uint32_t shift         = 14 - half_exponent;
+        const uint32_t remainder     = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway       = 1u << (shift - 1);
+        uint32_t       half_mantissa = mantissa >> shift;
+        if (remainder > halfway || (remainder == halfway && (half_mantissa & 1))) {
+            half_mantissa++;
+        }
+        return sign | half_mantissa;
+    }
+
+    // a carry out of the mantissa rounds up into the exponent, and into infinity past the largest half
+    uint32_t       half      = sign | (half_exponent << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        half++;
+    }
+    return half;
+}
+
+[[nodiscard]] static uint32_t pack_snorm16(float value) {
+    return static_cast<uint16_t>(static_cast<int16_t>(std::round(std::clamp(value, -1.f, 1.f) * 32767.f)));
+}
+
+[[nodiscard]] static uint32_t pack_unorm8(float value) { return static_cast<uint32_t>(std::round(std::clamp(value, 0.f, 1.f) * 255.f)); }
+
+// map a direction onto the octahedron, unfold its lower half over the upper one and store the result as two snorm16 values
+[[nodiscard]] static uint32_t encode_octahedral(const float direction[3]) {
+    const float length = std::abs(direction[0]) + std::abs(direction[1]) + std::abs(direction[2]);
+    float       u      = 0;
+    float       v      = 0;
+    if (length > 0) {
+        u = direction[0] / length;
+        v = direction[1] / length;
+        if (direction[2] < 0) {
+            const float folded_u = (1 - std::abs(v)) * (u >= 0 ? 1.f : -1.f);
+            v                    = (1 - std::abs(u)) * (v >= 0 ? 1.f : -1.f);
+            u                    = folded_u;
+        }
+    }
+    return pack_snorm16(u) | pack_snorm16(v) << 16;
+}
+
+// unorm16 across the bounds of one axis. flat axes quantize to 0, which decodes to the origin
+[[nodiscard]] static uint16_t quantize_position(float position, float origin, float extent) {
+    if (extent <= 0) {
+        return 0;
+    }
+    const float normalized = (position - (origin - extent)) / (2 * extent);
+    return static_cast<uint16_t>(std::round(std::clamp(normalized, 0.f, 1.f) * 65535.f));
+}
+
+// the attributes PackedVertex and QuantizedVertex have in common
+template <typename T> static void pack_vertex_attributes(const Vertex* vertex, T* packed_vertex) {
+    constexpr uint32_t tangent_sign_bit = 1u << 16;
+
+    packed_vertex->normal  = encode_octahedral(vertex->normal);
+    packed_vertex->tangent = (encode_octahedral(vertex->tangent) & ~tangent_sign_bit) | (vertex->tangent[3] < 0 ? tangent_sign_bit : 0);
+    packed_vertex->color   = pack_unorm8(vertex->color[0]) | pack_unorm8(vertex->color[1]) << 8 | pack_unorm8(vertex->color[2]) << 16 |
+                           pack_unorm8(vertex->color[3]) << 24;
+    for (uint32_t i = 0; i < 2; i++) {
+        packed_vertex->tex_coord[i][0] = float_to_half(vertex->tex_coord[i][0]);
+        packed_vertex->tex_coord[i][1] = float_to_half(vertex->tex_coord[i][1]);
+    }
+}
+
+// vertices built at once before they are streamed to staging memory. 15 KiB of full vertices, so a block stays in L1 while every attribute is
+// gathered into it, and its size in bytes is a multiple of 16 in every vertex format
+constexpr uint64_t vertex_block_count = 192;
+
+// write the vertices [first_vertex, first_vertex + vertex_count) of a primitive in vertex_format. vertices are built a block at a time,
+// packed if the format asks for it and streamed to vertex_data, so staging memory only ever sees sequential full writes
+static void write_primitive_vertex_data(const cgltf_primitive* gltf_primitive, VertexFormat vertex_format, const Bounds* bounds,
+                                        uint64_t first_vertex, uint64_t vertex_count, void* vertex_data) {
+    const uint32_t vertex_size = get_vertex_size(vertex_format);
+
+    Vertex          vertices[vertex_block_count];
+    PackedVertex    packed_vertices[vertex_block_count];
+    QuantizedVertex quantized_vertices[vertex_block_count];
+    for (uint64_t block_first = 0; block_first < vertex_count; block_first += vertex_block_count) {
+        const uint64_t block_count = std::min(vertex_block_count, vertex_count - block_first);
+
+        std::fill_n(vertices, block_count, Vertex{});
+        write_primitive_vertices(gltf_primitive, first_vertex + block_first, block_count, vertices);
+
+        const void* block_data = vertices;
+        if (vertex_format == VertexFormat::packed) {
+            for (uint64_t k = 0; k < block_count; k++) {
+                memcpy(packed_vertices[k].position, vertices[k].position, 3 * sizeof(float));
+                pack_vertex_attributes(&vertices[k], &packed_vertices[k]);
+            }
+            block_data = packed_vertices;
+        } else if (vertex_format == VertexFormat::quantized) {
+            for (uint64_t k = 0; k < block_count; k++) {
+                for (uint32_t axis = 0; axis < 3; axis++) {
+                    quantized_vertices[k].position[axis] = quantize_position(vertices[k].position[axis], bounds->origin[axis], bounds->extent[axis]);
+                }
+                quantized_vertices[k].padding = 0;
+                pack_vertex_attributes(&vertices[k], &quantized_vertices[k]);
+            }
+            block_data = quantized_vertices;
+        }
+
+        stream_to_staging(static_cast<uint8_t*>(vertex_data) + block_first * vertex_size, block_data, block_count * vertex_size);
+    }
+}
+
+uint32_t get_position_size(VertexFormat vertex_format) { return vertex_format == VertexFormat::quantized ? 4 * sizeof(uint16_t) : 3 * sizeof(float); }
+
+// write the positions [first_vertex, first_vertex + vertex_count) of a primitive to its position stream, encoded like the positions of
+// vertex_format. vertices past the end of the position accessor are left at the origin of the stream's encoding
+static void write_primitive_positions(const cgltf_primitive* gltf_primitive, VertexFormat vertex_format, const Bounds* bounds, uint64_t first_vertex,
+                                      uint64_t vertex_count, void* position_data) {
+    memset(position_data, 0, vertex_count * get_position_size(vertex_format));
+
+    for (uint32_t k = 0; k < gltf_primitive->attributes_count; k++) {
+        if (gltf_primitive->attributes[k].type != cgltf_attribute_type_position) {
+            continue;
+        }
+        const cgltf_accessor* position_accessor = gltf_primitive->attributes[k].data;
+        if (first_vertex >= position_accessor->count) {
+            continue;
+        }
+        const uint64_t position_count = std::min(first_vertex + vertex_count, position_accessor->count) - first_vertex;
+
+        if (vertex_format != VertexFormat::quantized) {
+            decode_accessor(position_accessor, first_vertex, position_count, 3, position_data, 3 * sizeof(float));
+            continue;
+        }
+
+        float positions[vertex_block_count * 3];
+        for (uint64_t block_first = 0; block_first < position_count; block_first += vertex_block_count) {
+            const uint64_t block_count = std::min(vertex_block_count, position_count - block_first);
+            decode_accessor(position_accessor, first_vertex + block_first, block_count, 3, positions, 3 * sizeof(float));
+
+            uint16_t* quantized_positions = &static_cast<uint16_t*>(position_data)[block_first * 4];
+            for (uint64_t position_idx = 0; position_idx < block_count; position_idx++) {
+                for (uint32_t axis = 0; axis < 3; axis++) {
+                    quantized_positions[position_idx * 4 + axis] =
+                        quantize_position(positions[position_idx * 3 + axis], bounds->origin[axis], bounds->extent[axis]);
+                }
+            }
+        }
+    }
+}
+
+using GeometryWrite = std::function<void(uint64_t first_element, uint64_t chunk_element_count, void* staging_data)>;
+
+// largest piece of a chunk one worker writes. small enough that the pieces of a single large primitive spread over every thread
+constexpr uint64_t geometry_write_piece_size = 1024 * 1024;
+
+// staging writes of the geometry of a load. staging memory is reserved and the copies out of it are recorded as primitives are uploaded,
+// while the writes are deferred and run on the worker pool together, so they spread across primitives and across pieces of large ones
+struct GeometryWriter {
+    WorkerPool*                        worker_pool{};
+    std::vector<std::function<void()>> pending_writes{};
+};
+
+// run every deferred write and wait for them. must happen before the ring can submit the copies that read them
+static void run_geometry_writes(GeometryWriter* writer) {
+    std::vector<std::future<void>> writes_done;
+    writes_done.reserve(writer->pending_writes.size());
+    for (std::function<void()>& write : writer->pending_writes) {
+        writes_done.push_back(worker_pool_submit(writer->worker_pool, std::move(write)));
+    }
+    for (std::future<void>& write_done : writes_done) {
+        write_done.get();
+    }
+    writer->pending_writes.clear();
+}
+
+// stream element_count elements generated by write straight into staging memory and copy them to dst_buffer at dst_offset. elements are
+// written a chunk at a time, so the data never has to fit into the ring at once. the pending writes run as soon as the ring would have to
+// submit to make room, and the rest run when the caller calls run_geometry_writes
+static void upload_generated_data(StagingRing* ring, GeometryWriter* writer, uint64_t element_count, uint64_t element_size, VkBuffer dst_buffer,
+                                  uint64_t dst_offset, const GeometryWrite& write) {
+    const uint64_t elements_per_chunk = std::max<uint64_t>(staging_ring_max_chunk_size(ring) / element_size, 1);
+    // pieces start at multiples of 16 elements, which keeps them as aligned as the chunk
+    const uint64_t elements_per_piece = std::max<uint64_t>(geometry_write_piece_size / element_size / 16 * 16, 16);
+
+    for (uint64_t first_element = 0; first_element < element_count; first_element += elements_per_chunk) {
+        const uint64_t chunk_element_count = std::min(elements_per_chunk, element_count - first_element);
+        const uint64_t chunk_size          = chunk_element_count * element_size;
+
+        if (!staging_ring_fits(ring, chunk_size, geometry_staging_alignment)) {
+            run_geometry_writes(writer);
+        }
+        void*          staging_data;
+        const uint64_t staging_offset = staging_ring_allocate(ring, chunk_size, geometry_staging_alignment, &staging_data);
+
+        for (uint64_t piece_first = 0; piece_first < chunk_element_count; piece_first += elements_per_piece) {
+            const uint64_t piece_element_count = std::min(elements_per_piece, chunk_element_count - piece_first);
+            uint8_t*       piece_data          = static_cast<uint8_t*>(staging_data) + piece_first * element_size;
+            writer->pending_writes.push_back([write, first_element, piece_first, piece_element_count, piece_data] {
+                write(first_element + piece_first, piece_element_count, piece_data);
+            });
         }
 
-        // 9. run copy commands to upload the staging data to image memory
+        const VkBufferCopy buffer_copy = vk_lib::buffer_copy(chunk_size, staging_offset, dst_offset + first_element * element_size);
+        vkCmdCopyBuffer(staging_ring_command_buffer(ring), ring->buffer.buffer, dst_buffer, 1, &buffer_copy);
+    }
+}
+
+// writes run after the primitive has been moved into its mesh, so they hold a copy of its format and bounds instead of a pointer to it
+[[nodiscard]] static GeometryWrite get_vertex_data_write(const cgltf_primitive* gltf_primitive, const GltfPrimitive* primitive) {
+    return [gltf_primitive, vertex_format = primitive->vertex_format, bounds = primitive->bounds](uint64_t first_vertex, uint64_t vertex_count,
+                                                                                                 void* staging_data) {
+        write_primitive_vertex_data(gltf_primitive, vertex_format, &bounds, first_vertex, vertex_count, staging_data);
+    };
+}
 
-        vk_command_immediate_submit(device, command_pool, queue, [&](VkCommandBuffer cmd_buf) {
-            // TODO: specify more fine grained stage and access flags
-            const VkImageMemoryBarrier2 copy_memory_barrier =
-                vk_lib::image_memory_barrier_2(new_texture.image, subresource_range, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+[[nodiscard]] static GeometryWrite get_position_write(const cgltf_primitive* gltf_primitive, const GltfPrimitive* primitive) {
+    return [gltf_primitive, vertex_format = primitive->vertex_format, bounds = primitive->bounds](uint64_t first_vertex, uint64_t vertex_count,
+                                                                                                 void* staging_data) {
+        write_primitive_positions(gltf_primitive, vertex_format, &bounds, first_vertex, vertex_count, staging_data);
+    };
+}
 
-            const VkDependencyInfo copy_dependency_info = vk_lib::dependency_info(&copy_memory_barrier, nullptr, nullptr);
-            vkCmdPipelineBarrier2(cmd_buf, &copy_dependency_info);
+[[nodiscard]] static GeometryWrite get_index_write(const cgltf_accessor* indices_accessor) {
+    return [indices_accessor](uint64_t first_index, uint64_t index_count, void* staging_data) {
+        decode_accessor_indices(indices_accessor, first_index, index_count, static_cast<uint32_t*>(staging_data));
+    };
+}
 
-            vkCmdCopyBufferToImage(cmd_buf, staging_buffer->buffer, new_texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                   buffer_image_copies.size(), buffer_image_copies.data());
+// reserve size bytes at a multiple of alignment from the newest geometry arena of the loader context, or from a new arena if it is full.
+// arenas are bump allocated and never reuse space
+static void allocate_from_geometry_arena(LoaderContext* loader_context, uint64_t size, uint64_t alignment, uint32_t* arena_index,
+                                         uint64_t* arena_offset) {
+    if (!loader_context->geometry_arenas.empty()) {
+        GeometryArena* arena  = &loader_context->geometry_arenas.back();
+        const uint64_t offset = align_up(arena->used, alignment);
+        if (offset + size <= arena->size) {
+            arena->used   = offset + size;
+            *arena_index  = loader_context->geometry_arenas.size() - 1;
+            *arena_offset = offset;
+            return;
+        }
+    }
 
-            // TODO: specify more fine grained stage and access flags
-            const VkImageMemoryBarrier2 texture_use_memory_barrier = vk_lib::image_memory_barrier_2(
-                new_texture.image, subresource_range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    GeometryArena arena{};
+    arena.size = std::max(loader_context->geometry_arena_size, size);
+    arena.used = size;
 
-            const VkDependencyInfo texture_use_dependency_info = vk_lib::dependency_info(&texture_use_memory_barrier, nullptr, nullptr);
-            vkCmdPipelineBarrier2(cmd_buf, &texture_use_dependency_info);
-        });
+    VkBufferCreateInfo arena_buffer_ci = vk_lib::buffer_create_info(
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, arena.size);
+    VmaAllocationCreateInfo allocation_ci{};
+    allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+    VK_CHECK(vmaCreateBuffer(loader_context->allocator, &arena_buffer_ci, &allocation_ci, &arena.buffer.buffer, &arena.buffer.allocation,
+                             &arena.buffer.allocation_info));
 
-        ktxTexture2_Destroy(ktx_texture);
+    VkBufferDeviceAddressInfo device_address_info = vk_lib::buffer_device_address_info(arena.buffer.buffer);
+    arena.buffer.address                          = vkGetBufferDeviceAddress(loader_context->device, &device_address_info);
 
-        new_texture.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    loader_context->geometry_arenas.push_back(arena);
+    *arena_index  = loader_context->geometry_arenas.size() - 1;
+    *arena_offset = 0;
+}
 
-        gltf_images.push_back(new_texture);
+// place the vertices of a primitive followed by its uint32 indices in a geometry arena
+static void upload_packed_primitive(const cgltf_primitive* gltf_primitive, bool split_positions, LoaderContext* loader_context,
+                                    GeometryWriter* writer, GltfPrimitive* primitive, LoadStats* load_stats) {
+    const uint64_t index_count        = gltf_primitive->indices ? gltf_primitive->indices->count : 0;
+    const uint32_t vertex_size        = get_vertex_size(primitive->vertex_format);
+    const uint32_t position_size      = get_position_size(primitive->vertex_format);
+    const uint64_t vertex_data_size   = primitive->vertex_count * vertex_size;
+    const uint64_t position_data_size = split_positions ? primitive->vertex_count * position_size : 0;
+    const uint64_t index_data_size    = index_count * sizeof(uint32_t);
+
+    // the vertices are followed by the position stream, if any, and then the indices. every vertex and position size is a multiple of 4, so
+    // everything after the vertices is aligned as well
+    uint32_t arena_index;
+    uint64_t arena_offset;
+    allocate_from_geometry_arena(loader_context, vertex_data_size + position_data_size + index_data_size, vertex_size, &arena_index, &arena_offset);
+    const GltfBuffer* arena_buffer_info = &loader_context->geometry_arenas[arena_index].buffer;
+    const VkBuffer    arena_buffer      = arena_buffer_info->buffer;
+    const uint64_t    position_offset   = arena_offset + vertex_data_size;
+    const uint64_t    index_offset      = position_offset + position_data_size;
+
+    primitive->geometry_arena = arena_index;
+    primitive->vertex_offset  = static_cast<int32_t>(arena_offset / vertex_size);
+    primitive->first_index    = static_cast<uint32_t>(index_offset / sizeof(uint32_t));
+    primitive->index_count    = index_count;
+    primitive->index_type     = VK_INDEX_TYPE_UINT32;
+
+    StagingRing* ring = loader_context->staging_ring;
+    upload_generated_data(ring, writer, primitive->vertex_count, vertex_size, arena_buffer, arena_offset,
+                          get_vertex_data_write(gltf_primitive, primitive));
+    if (split_positions) {
+        // draws index both streams with vertex_offset included, so the stream's address is moved back by vertex_offset positions. it never
+        // ends up before the arena, since positions are no larger than vertices
+        primitive->position_address = arena_buffer_info->address + position_offset - static_cast<uint64_t>(primitive->vertex_offset) * position_size;
+        upload_generated_data(ring, writer, primitive->vertex_count, position_size, arena_buffer, position_offset,
+                              get_position_write(gltf_primitive, primitive));
+    }
+    if (gltf_primitive->indices) {
+        upload_generated_data(ring, writer, index_count, sizeof(uint32_t), arena_buffer, index_offset, get_index_write(gltf_primitive->indices));
     }
 
-    return gltf_images;
+    load_stats->geometry_bytes_uploaded += vertex_data_size + position_data_size + index_data_size;
 }
 
-[[nodiscard]] static std::vector<VkSampler> load_gltf_samplers(const cgltf_data* cgltf_data, VkDevice device) {
-    std::vector<VkSampler> samplers;
-    samplers.reserve(cgltf_data->samplers_count);
+// create a dedicated index and vertex buffer for a primitive and upload its data as is
+static void upload_primitive(const cgltf_primitive* gltf_primitive, bool split_positions, LoaderContext* loader_context, GeometryWriter* writer,
+                             GltfPrimitive* primitive, LoadStats* load_stats) {
+    VmaAllocator allocator = loader_context->allocator;
+    StagingRing* ring      = loader_context->staging_ring;
+
+    // load indices if present
+    if (gltf_primitive->indices) {
+        const cgltf_accessor* indices_accessor = gltf_primitive->indices;
+        const bool            copy_indices     = can_copy_indices(indices_accessor);
+        if (!copy_indices || indices_accessor->component_type == cgltf_component_type_r_32u) {
+            primitive->index_type = VK_INDEX_TYPE_UINT32;
+        }
+        const uint64_t total_data_size = get_primitive_index_data_size(gltf_primitive);
+        primitive->index_count         = indices_accessor->count;
+
+        // create the actual index buffer on the gpu
+        VkBufferCreateInfo indices_buffer_ci =
+            vk_lib::buffer_create_info(VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, total_data_size);
+        VmaAllocationCreateInfo allocation_ci{};
+        allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+        allocation_ci.flags = VMA_ALLOCATION_CREATE_STRATEGY_MIN_MEMORY_BIT;
+
+        GltfBuffer index_buffer{};
+        VK_CHECK(vmaCreateBuffer(allocator, &indices_buffer_ci, &allocation_ci, &index_buffer.buffer, &index_buffer.allocation,
+                                 &index_buffer.allocation_info));
+
+        primitive->index_buffer = index_buffer;
+
+        // copied indices go through the geometry writer as well, so they can't make the ring submit before the pending writes ran
+        if (copy_indices) {
+            const uint8_t* index_data =
+                static_cast<uint8_t*>(indices_accessor->buffer_view->buffer->data) + indices_accessor->offset + indices_accessor->buffer_view->offset;
+            const uint64_t index_size = cgltf_component_size(indices_accessor->component_type);
+            upload_generated_data(ring, writer, indices_accessor->count, index_size, index_buffer.buffer, 0,
+                                  [index_data, index_size](uint64_t first_index, uint64_t index_count, void* staging_data) {
+                                      stream_to_staging(staging_data, index_data + first_index * index_size, index_count * index_size);
+                                  });
+        } else {
+            upload_generated_data(ring, writer, indices_accessor->count, sizeof(uint32_t), index_buffer.buffer, 0, get_index_write(indices_accessor));
+        }
+    }
 
-    for (uint32_t i = 0; i < cgltf_data->samplers_count; i++) {
-        const cgltf_sampler* cgltf_sampler = &cgltf_data->samplers[i];
+    const uint32_t vertex_size      = get_vertex_size(primitive->vertex_format);
+    const uint64_t vertex_data_size = primitive->vertex_count * vertex_size;
 
-        VkSamplerCreateInfo sampler_info = {};
-        sampler_info.sType               = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    // create the actual vertex buffer on the gpu
+    VkBufferCreateInfo vertex_buffer_ci =
+        vk_lib::buffer_create_info(VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, vertex_data_size);
 
-        switch (cgltf_sampler->mag_filter) {
-        case cgltf_filter_type_nearest:
-        case cgltf_filter_type_nearest_mipmap_nearest:
-        case cgltf_filter_type_nearest_mipmap_linear:
-            sampler_info.magFilter = VK_FILTER_NEAREST;
-            break;
-        default:
-            sampler_info.magFilter = VK_FILTER_LINEAR;
-            break;
-        }
+    VmaAllocationCreateInfo allocation_ci{};
+    allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+    allocation_ci.flags = VMA_ALLOCATION_CREATE_STRATEGY_MIN_MEMORY_BIT;
 
-        switch (cgltf_sampler->min_filter) {
-        case cgltf_filter_type_nearest:
-        case cgltf_filter_type_nearest_mipmap_nearest:
-            sampler_info.minFilter  = VK_FILTER_NEAREST;
-            sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-            break;
+    VK_CHECK(vmaCreateBuffer(allocator, &vertex_buffer_ci, &allocation_ci, &primitive->vertex_buffer.buffer, &primitive->vertex_buffer.allocation,
+                             &primitive->vertex_buffer.allocation_info));
 
-        case cgltf_filter_type_linear:
-        case cgltf_filter_type_linear_mipmap_nearest:
-            sampler_info.minFilter  = VK_FILTER_LINEAR;
-            sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-            break;
+    // vertices are built directly in staging memory, so large primitives are written in chunks that fit the ring
+    upload_generated_data(ring, writer, primitive->vertex_count, vertex_size, primitive->vertex_buffer.buffer, 0,
+                          get_vertex_data_write(gltf_primitive, primitive));
 
-        case cgltf_filter_type_nearest_mipmap_linear:
-            sampler_info.minFilter  = VK_FILTER_NEAREST;
-            sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-            break;
+    load_stats->geometry_bytes_uploaded += vertex_data_size + get_primitive_index_data_size(gltf_primitive);
 
-        default:
-            sampler_info.minFilter  = VK_FILTER_LINEAR;
-            sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-            break;
-        }
+    VkBufferDeviceAddressInfo device_address_info = vk_lib::buffer_device_address_info(primitive->vertex_buffer.buffer);
+    primitive->vertex_buffer.address              = vkGetBufferDeviceAddress(loader_context->device, &device_address_info);
 
-        switch (cgltf_sampler->wrap_s) {
-        case cgltf_wrap_mode_clamp_to_edge:
-            sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-            break;
-        case cgltf_wrap_mode_mirrored_repeat:
-            sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
-            break;
-        default:
-            sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-            break;
-        }
+    if (split_positions) {
+        const uint32_t position_size      = get_position_size(primitive->vertex_format);
+        const uint64_t position_data_size = primitive->vertex_count * position_size;
 
-        switch (cgltf_sampler->wrap_t) {
-        case cgltf_wrap_mode_clamp_to_edge:
-            sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-            break;
+        VkBufferCreateInfo position_buffer_ci =
+            vk_lib::buffer_create_info(VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, position_data_size);
 
-        case cgltf_wrap_mode_mirrored_repeat:
-            sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
-            break;
-        default:
-            sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-            break;
-        }
+        GltfBuffer position_buffer{};
+        VK_CHECK(vmaCreateBuffer(allocator, &position_buffer_ci, &allocation_ci, &position_buffer.buffer, &position_buffer.allocation,
+                                 &position_buffer.allocation_info));
 
-        sampler_info.addressModeW            = sampler_info.addressModeV; // Usually the same as V
-        sampler_info.anisotropyEnable        = VK_TRUE;
-        sampler_info.maxAnisotropy           = 16.0f;
-        sampler_info.borderColor             = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
-        sampler_info.unnormalizedCoordinates = VK_FALSE;
-        sampler_info.compareEnable           = VK_FALSE;
-        sampler_info.compareOp               = VK_COMPARE_OP_NEVER;
-        sampler_info.mipLodBias              = 0.0f;
-        sampler_info.minLod                  = 0.0f;
-        sampler_info.maxLod                  = VK_LOD_CLAMP_NONE;
+        upload_generated_data(ring, writer, primitive->vertex_count, position_size, position_buffer.buffer, 0,
+                              get_position_write(gltf_primitive, primitive));
 
-        VkSampler sampler;
-        VK_CHECK(vkCreateSampler(device, &sampler_info, nullptr, &sampler));
+        device_address_info         = vk_lib::buffer_device_address_info(position_buffer.buffer);
+        position_buffer.address     = vkGetBufferDeviceAddress(loader_context->device, &device_address_info);
+        primitive->position_buffer  = position_buffer;
+        primitive->position_address = position_buffer.address;
 
-        samplers.push_back(sampler);
+        load_stats->geometry_bytes_uploaded += position_data_size;
     }
-
-    return samplers;
 }
 
-// create meshes along with primitives. allocate vertex and index buffers on gpu
-[[nodiscard]] static std::vector<GltfMesh> load_gltf_meshes(const cgltf_data* cgltf_data, VkDevice device, VkQueue queue, VkCommandPool command_pool,
-                                                            VmaAllocator allocator, GltfBuffer* staging_buffer) {
+// create meshes along with primitives. allocate vertex and index buffers on gpu, or sub-allocate them from geometry arenas when packing.
+// index and vertex data are written straight into the staging ring in chunks by the worker pool, in parallel across primitives, and every
+// copy is recorded into the ring's command buffer. an asset is uploaded with one submit unless its geometry fills the ring, in which case
+// writing overlaps with earlier transfers. a cancelled load returns only the meshes uploaded before it noticed
+[[nodiscard]] static std::vector<GltfMesh> load_gltf_meshes(const LoadOptions* load_options, const cgltf_data* cgltf_data,
+                                                            const LoadSelection* selection, LoaderContext* loader_context, LoadStats* load_stats,
+                                                            WorkerPool* worker_pool, LoadTracker* load_tracker) {
     std::vector<GltfMesh> meshes;
-    meshes.reserve(cgltf_data->meshes_count);
+    meshes.reserve(selection->meshes.kept.size());
 
-    for (uint32_t i = 0; i < cgltf_data->meshes_count; i++) {
-        const cgltf_mesh* gltf_mesh = &cgltf_data->meshes[i];
+    GeometryWriter writer{};
+    writer.worker_pool = worker_pool;
+
+    for (uint32_t mesh_index : selection->meshes.kept) {
+        if (is_load_cancelled(load_tracker)) {
+            break;
+        }
+        const cgltf_mesh* gltf_mesh = &cgltf_data->meshes[mesh_index];
 
         GltfMesh mesh;
 
@@ -677,7 +2315,7 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
 
             GltfPrimitive primitive{};
             if (gltf_primitive->material) {
-                primitive.material = gltf_primitive->material - cgltf_data->materials;
+                primitive.material = selection->materials.asset_index[gltf_primitive->material - cgltf_data->materials];
             }
 
             switch (gltf_primitive->type) {
@@ -701,213 +2339,47 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
                 primitive.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
             }
 
-            // load indices if present
-            if (gltf_primitive->indices) {
-                const cgltf_accessor* indices_accessor    = gltf_primitive->indices;
-                uint32_t              component_byte_size = 2;
-                if (gltf_primitive->indices->component_type == cgltf_component_type_r_32u) {
-                    primitive.index_type = VK_INDEX_TYPE_UINT32;
-                    component_byte_size  = 4;
-                }
-                uint32_t total_data_size = component_byte_size * indices_accessor->count;
-                // up the size of the staging buffer if needed
-                if (staging_buffer->allocation_info.size < total_data_size) {
-                    allocate_staging_buffer(allocator, total_data_size, staging_buffer);
-                }
-                primitive.index_count = indices_accessor->count;
-                memcpy(staging_buffer->allocation_info.pMappedData,
-                       static_cast<uint8_t*>(indices_accessor->buffer_view->buffer->data) + indices_accessor->offset +
-                           indices_accessor->buffer_view->offset,
-                       total_data_size);
-
-                VkBufferCopy buffer_copy = vk_lib::buffer_copy(total_data_size);
-
-                // create the actual index buffer on the gpu
-                VkBufferCreateInfo indices_buffer_ci =
-                    vk_lib::buffer_create_info(VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, total_data_size);
-                VmaAllocationCreateInfo allocation_ci{};
-                allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
-                allocation_ci.flags = VMA_ALLOCATION_CREATE_STRATEGY_MIN_MEMORY_BIT;
-
-                GltfBuffer index_buffer{};
-                VK_CHECK(vmaCreateBuffer(allocator, &indices_buffer_ci, &allocation_ci, &index_buffer.buffer, &index_buffer.allocation,
-                                         &index_buffer.allocation_info));
-
-                primitive.index_buffer = index_buffer;
-
-                vk_command_immediate_submit(device, command_pool, queue, [&](VkCommandBuffer cmd_buf) {
-                    vkCmdCopyBuffer(cmd_buf, staging_buffer->buffer, primitive.index_buffer->buffer, 1, &buffer_copy);
-                });
-            }
-
-            // pre-allocate staging buffer to hold all per-vertex attributes
-            size_t attribute_count = 0;
-            for (uint64_t k = 0; k < gltf_primitive->attributes_count; k++) {
-                attribute_count = std::max(attribute_count, gltf_primitive->attributes[k].data->count);
-            }
-
-            uint64_t vertex_data_size = attribute_count * sizeof(Vertex);
-
-            if (staging_buffer->allocation_info.size < vertex_data_size) {
-                allocate_staging_buffer(allocator, vertex_data_size, staging_buffer);
-            }
-
-            Vertex* vertex_arr = static_cast<Vertex*>(staging_buffer->allocation_info.pMappedData);
-
-            // Indicates if we need to go back and fill in vertex attributes with default data if the accessor for this attribute
-            // wasn't found. Don't pre-initialize the vertex_arr since will be a lot of wasted computation many times.
-            // currently only worried about colors not being found
-            bool colors_found = false;
-
-            // load all per-vertex attributes
-            for (uint32_t k = 0; k < gltf_primitive->attributes_count; k++) {
-                const cgltf_attribute* gltf_attribute = &gltf_primitive->attributes[k];
-                // get vertex positions
-                if (gltf_attribute->type == cgltf_attribute_type_position) {
-                    const cgltf_accessor* position_accessor = gltf_attribute->data;
-
-                    //  find bounds
-                    {
-                        float min_pos[3], max_pos[3];
-                        memcpy(min_pos, position_accessor->min, 3 * sizeof(float));
-                        memcpy(max_pos, position_accessor->max, 3 * sizeof(float));
-
-                        primitive.bounds.origin[0] = (min_pos[0] + max_pos[0]) / 2.f;
-                        primitive.bounds.origin[1] = (min_pos[1] + max_pos[1]) / 2.f;
-                        primitive.bounds.origin[2] = (min_pos[2] + max_pos[2]) / 2.f;
-
-                        primitive.bounds.extent[0] = (max_pos[0] - min_pos[0]) / 2.f;
-                        primitive.bounds.extent[1] = (max_pos[1] - min_pos[1]) / 2.f;
-                        primitive.bounds.extent[2] = (max_pos[2] - min_pos[2]) / 2.f;
-
-                        float ex_0 = primitive.bounds.extent[0];
-                        float ex_1 = primitive.bounds.extent[1];
-                        float ex_2 = primitive.bounds.extent[2];
-
-                        primitive.bounds.sphere_radius = sqrt((ex_0 * ex_0) + (ex_1 * ex_1) + (ex_2 * ex_2));
-                    }
-
-                    // for now, assume its always vec3's of 32f's
-                    for (uint64_t position_idx = 0; position_idx < position_accessor->count; position_idx++) {
-                        const float* gltf_position = reinterpret_cast<const float*>(
-                            static_cast<uint8_t*>(position_accessor->buffer_view->buffer->data) + position_accessor->offset +
-                            position_accessor->buffer_view->offset + position_idx * position_accessor->stride);
-
-                        memcpy(vertex_arr[position_idx].position, gltf_position, 3 * sizeof(float));
-                    }
-                }
-
-                // get vertex normals
-                if (gltf_attribute->type == cgltf_attribute_type_normal) {
-                    const cgltf_accessor* normal_accessor = gltf_attribute->data;
-                    for (uint64_t normal_idx = 0; normal_idx < normal_accessor->count; normal_idx++) {
-                        const float* gltf_normal = reinterpret_cast<const float*>(static_cast<uint8_t*>(normal_accessor->buffer_view->buffer->data) +
-                                                                                  normal_accessor->offset + normal_accessor->buffer_view->offset +
-                                                                                  normal_idx * normal_accessor->stride);
-
-                        memcpy(vertex_arr[normal_idx].normal, gltf_normal, 3 * sizeof(float));
-                    }
-                }
-                // get uv's
-                if (gltf_attribute->type == cgltf_attribute_type_texcoord) {
-                    const cgltf_accessor* uv_accessor = gltf_attribute->data;
-
-                    // only handling 2 texture coordinates per vertex for now
-                    uint32_t tex_coord_idx;
-                    if (strcmp(gltf_attribute->name, "TEXCOORD_0") == 0) {
-                        tex_coord_idx = 0;
-                    } else if (strcmp(gltf_attribute->name, "TEXCOORD_1") == 0) {
-                        tex_coord_idx = 1;
-                    } else {
-                        continue;
-                        // abort_message("gltf loading does not handle more than 2 texture coordinates per vertex");
-                    }
-
-                    for (uint64_t uv_idx = 0; uv_idx < uv_accessor->count; uv_idx++) {
-                        const float* gltf_uv =
-                            reinterpret_cast<const float*>(static_cast<uint8_t*>(uv_accessor->buffer_view->buffer->data) + uv_accessor->offset +
-                                                           uv_accessor->buffer_view->offset + uv_idx * uv_accessor->stride);
-
-                        memcpy(vertex_arr[uv_idx].tex_coord[tex_coord_idx], gltf_uv, 2 * sizeof(float));
-                    }
-                }
-
-                if (gltf_attribute->type == cgltf_attribute_type_color) {
-                    colors_found                         = true;
-                    const cgltf_accessor* color_accessor = gltf_attribute->data;
-                    for (uint64_t color_idx = 0; color_idx < color_accessor->count; color_idx++) {
-                        const float* gltf_color =
-                            reinterpret_cast<const float*>(static_cast<uint8_t*>(color_accessor->buffer_view->buffer->data) + color_accessor->offset +
-                                                           color_accessor->buffer_view->offset + color_idx * color_accessor->stride);
-
-                        if (color_accessor->type == cgltf_type_vec3) {
-                            float color[4] = {gltf_color[0], gltf_color[1], gltf_color[2], 1};
-                            memcpy(vertex_arr[color_idx].color, color, 4 * sizeof(float));
-                        } else if (color_accessor->type == cgltf_type_vec4) {
-                            float color[4] = {gltf_color[0], gltf_color[1], gltf_color[2], gltf_color[4]};
-                            memcpy(vertex_arr[color_idx].color, color, 4 * sizeof(float));
-                        }
-                    }
-                }
-
-                // get tangents
-                if (gltf_attribute->type == cgltf_attribute_type_tangent) {
-                    const cgltf_accessor* tangent_accessor = gltf_attribute->data;
-                    for (uint64_t tangent_idx = 0; tangent_idx < tangent_accessor->count; tangent_idx++) {
-                        const float* gltf_tangent = reinterpret_cast<const float*>(
-                            static_cast<uint8_t*>(tangent_accessor->buffer_view->buffer->data) + tangent_accessor->offset +
-                            tangent_accessor->buffer_view->offset + tangent_idx * tangent_accessor->stride);
+            primitive.vertex_count  = get_primitive_vertex_count(gltf_primitive);
+            primitive.vertex_format = load_options->vertex_format;
+            get_primitive_bounds(gltf_primitive, &primitive.bounds);
 
-                        memcpy(vertex_arr[tangent_idx].tangent, gltf_tangent, 4 * sizeof(float));
-                    }
-                }
-            }
-
-            if (!colors_found) {
-                float default_color[4] = {1, 1, 1, 1};
-                for (uint64_t k = 0; k < attribute_count; k++) {
-                    memcpy(vertex_arr[k].color, default_color, 4 * sizeof(float));
-                }
+            if (load_options->pack_geometry) {
+                upload_packed_primitive(gltf_primitive, load_options->split_positions, loader_context, &writer, &primitive, load_stats);
+            } else {
+                upload_primitive(gltf_primitive, load_options->split_positions, loader_context, &writer, &primitive, load_stats);
             }
 
-            // upload per-vertex attributes to the gpu and get the device address for it
-
-            VkBufferCopy buffer_copy = vk_lib::buffer_copy(vertex_data_size);
-
-            // create the actual index buffer on the gpu
-            VkBufferCreateInfo vertex_buffer_ci =
-                vk_lib::buffer_create_info(VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, vertex_data_size);
-
-            VmaAllocationCreateInfo allocation_ci{};
-            allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
-            allocation_ci.flags = VMA_ALLOCATION_CREATE_STRATEGY_MIN_MEMORY_BIT;
-
-            VK_CHECK(vmaCreateBuffer(allocator, &vertex_buffer_ci, &allocation_ci, &primitive.vertex_buffer.buffer,
-                                     &primitive.vertex_buffer.allocation, &primitive.vertex_buffer.allocation_info));
-
-            vk_command_immediate_submit(device, command_pool, queue, [&](VkCommandBuffer cmd_buf) {
-                vkCmdCopyBuffer(cmd_buf, staging_buffer->buffer, primitive.vertex_buffer.buffer, 1, &buffer_copy);
-            });
-
-            VkBufferDeviceAddressInfo device_address_info = vk_lib::buffer_device_address_info(primitive.vertex_buffer.buffer);
-            primitive.vertex_buffer.address               = vkGetBufferDeviceAddress(device, &device_address_info);
-
             mesh.primitives.push_back(primitive);
         }
         meshes.push_back(mesh);
+
+        if (load_tracker) {
+            load_tracker->meshes_loaded++;
+            report_bytes_uploaded(load_tracker, load_stats);
+        }
     }
 
+    // the copies of the last writes are submitted by the caller, and the primitives they read from are freed along with cgltf_data
+    run_geometry_writes(&writer);
+
     return meshes;
 }
 
-[[nodiscard]] static std::vector<GltfMaterial> load_gltf_materials(const cgltf_data* cgltf_data) {
+// threads that write geometry while the image pool keeps encoding streamed full chains. the writes are bound by memory bandwidth, so a quarter
+// of the thread budget keeps them fast without oversubscribing the cpu next to the encodes
+[[nodiscard]] static uint32_t get_streaming_geometry_thread_count(const LoadOptions* load_options) {
+    const uint32_t thread_budget = load_options->thread_count != 0 ? load_options->thread_count : std::thread::hardware_concurrency();
+    return std::max(thread_budget / 4, 1u);
+}
+
+[[nodiscard]] static std::vector<GltfMaterial> load_gltf_materials(const cgltf_data* cgltf_data, const LoadSelection* selection) {
     std::vector<GltfMaterial> materials;
-    materials.reserve(cgltf_data->materials_count);
+    materials.reserve(selection->materials.kept.size());
 
-    for (uint32_t i = 0; i < cgltf_data->materials_count; i++) {
+    for (uint32_t material_index : selection->materials.kept) {
         GltfMaterial material{};
 
-        const cgltf_material* gltf_material = &cgltf_data->materials[i];
+        const cgltf_material* gltf_material = &cgltf_data->materials[material_index];
 
         material.alpha_mode = static_cast<GltfAlphaMode>(gltf_material->alpha_mode);
 
@@ -922,7 +2394,7 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
 
             if (metal_rough->base_color_texture.texture) {
                 TextureInfo color_tex_info{};
-                color_tex_info.tex_index = metal_rough->base_color_texture.texture - cgltf_data->textures;
+                color_tex_info.tex_index = selection->textures.asset_index[metal_rough->base_color_texture.texture - cgltf_data->textures];
                 color_tex_info.tex_coord = metal_rough->base_color_texture.texcoord;
 
                 material.base_color_texture = color_tex_info;
@@ -930,7 +2402,8 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
 
             if (metal_rough->metallic_roughness_texture.texture) {
                 TextureInfo metal_rough_tex_info{};
-                metal_rough_tex_info.tex_index = metal_rough->metallic_roughness_texture.texture - cgltf_data->textures;
+                metal_rough_tex_info.tex_index =
+                    selection->textures.asset_index[metal_rough->metallic_roughness_texture.texture - cgltf_data->textures];
                 metal_rough_tex_info.tex_coord = metal_rough->metallic_roughness_texture.texcoord;
 
                 material.metallic_roughness_texture = metal_rough_tex_info;
@@ -940,7 +2413,7 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
         // normal texture
         if (gltf_material->normal_texture.texture) {
             TextureInfo normal_tex_info{};
-            normal_tex_info.tex_index = gltf_material->normal_texture.texture - cgltf_data->textures;
+            normal_tex_info.tex_index = selection->textures.asset_index[gltf_material->normal_texture.texture - cgltf_data->textures];
             normal_tex_info.tex_coord = gltf_material->normal_texture.texcoord;
 
             material.normal_texture = normal_tex_info;
@@ -950,7 +2423,7 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
         // occlusion texture
         if (gltf_material->occlusion_texture.texture) {
             TextureInfo occlusion_tex_info{};
-            occlusion_tex_info.tex_index = gltf_material->occlusion_texture.texture - cgltf_data->textures;
+            occlusion_tex_info.tex_index = selection->textures.asset_index[gltf_material->occlusion_texture.texture - cgltf_data->textures];
             occlusion_tex_info.tex_coord = gltf_material->occlusion_texture.texcoord;
 
             material.occlusion_texture = occlusion_tex_info;
@@ -960,7 +2433,7 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
         // emissive texture
         if (gltf_material->emissive_texture.texture) {
             TextureInfo emissive_tex_info{};
-            emissive_tex_info.tex_index = gltf_material->emissive_texture.texture - cgltf_data->textures;
+            emissive_tex_info.tex_index = selection->textures.asset_index[gltf_material->emissive_texture.texture - cgltf_data->textures];
             emissive_tex_info.tex_coord = gltf_material->emissive_texture.texcoord;
 
             material.emissive_texture = emissive_tex_info;
@@ -972,21 +2445,24 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
         if (gltf_material->has_clearcoat) {
             if (gltf_material->clearcoat.clearcoat_texture.texture) {
                 TextureInfo clearcoat_tex_info{};
-                clearcoat_tex_info.tex_index = gltf_material->clearcoat.clearcoat_texture.texture - cgltf_data->textures;
+                clearcoat_tex_info.tex_index =
+                    selection->textures.asset_index[gltf_material->clearcoat.clearcoat_texture.texture - cgltf_data->textures];
                 clearcoat_tex_info.tex_coord = gltf_material->clearcoat.clearcoat_texture.texcoord;
 
                 material.clearcoat_texture = clearcoat_tex_info;
             }
             if (gltf_material->clearcoat.clearcoat_roughness_texture.texture) {
                 TextureInfo clearcoat_rough_tex_info{};
-                clearcoat_rough_tex_info.tex_index = gltf_material->clearcoat.clearcoat_roughness_texture.texture - cgltf_data->textures;
+                clearcoat_rough_tex_info.tex_index =
+                    selection->textures.asset_index[gltf_material->clearcoat.clearcoat_roughness_texture.texture - cgltf_data->textures];
                 clearcoat_rough_tex_info.tex_coord = gltf_material->clearcoat.clearcoat_roughness_texture.texcoord;
 
                 material.clearcoat_roughness_texture = clearcoat_rough_tex_info;
             }
             if (gltf_material->clearcoat.clearcoat_normal_texture.texture) {
                 TextureInfo clearcoat_normal_tex_info{};
-                clearcoat_normal_tex_info.tex_index = gltf_material->clearcoat.clearcoat_normal_texture.texture - cgltf_data->textures;
+                clearcoat_normal_tex_info.tex_index =
+                    selection->textures.asset_index[gltf_material->clearcoat.clearcoat_normal_texture.texture - cgltf_data->textures];
                 clearcoat_normal_tex_info.tex_coord = gltf_material->clearcoat.clearcoat_normal_texture.texcoord;
 
                 material.clearcoat_normal_texture = clearcoat_normal_tex_info;
@@ -1001,13 +2477,13 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
     return materials;
 }
 
-[[nodiscard]] static std::vector<GltfNode> load_gltf_nodes(const cgltf_data* cgltf_data) {
+[[nodiscard]] static std::vector<GltfNode> load_gltf_nodes(const cgltf_data* cgltf_data, const LoadSelection* selection) {
     std::vector<GltfNode> nodes;
-    nodes.reserve(cgltf_data->nodes_count);
+    nodes.reserve(selection->nodes.kept.size());
 
-    for (uint32_t i = 0; i < cgltf_data->nodes_count; i++) {
+    for (uint32_t node_index : selection->nodes.kept) {
         GltfNode          node{};
-        const cgltf_node* gltf_node = &cgltf_data->nodes[i];
+        const cgltf_node* gltf_node = &cgltf_data->nodes[node_index];
 
         cgltf_node_transform_local(gltf_node, node.local_transform);
         cgltf_node_transform_world(gltf_node, node.world_transform);
@@ -1015,15 +2491,15 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
         node.children.reserve(gltf_node->children_count);
 
         for (uint32_t j = 0; j < gltf_node->children_count; j++) {
-            node.children.push_back(gltf_node->children[j] - cgltf_data->nodes);
+            node.children.push_back(selection->nodes.asset_index[gltf_node->children[j] - cgltf_data->nodes]);
         }
         if (gltf_node->mesh) {
-            node.mesh = gltf_node->mesh - cgltf_data->meshes;
+            node.mesh = selection->meshes.asset_index[gltf_node->mesh - cgltf_data->meshes];
         }
 
         // EXTENSIONS
         if (gltf_node->light) {
-            node.light = gltf_node->light - cgltf_data->lights;
+            node.light = selection->lights.asset_index[gltf_node->light - cgltf_data->lights];
         }
 
         nodes.push_back(node);
@@ -1032,21 +2508,21 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
     return nodes;
 }
 
-[[nodiscard]] static std::vector<GltfTexture> load_gltf_textures(const cgltf_data* cgltf_data) {
+[[nodiscard]] static std::vector<GltfTexture> load_gltf_textures(const cgltf_data* cgltf_data, const LoadSelection* selection) {
 
     std::vector<GltfTexture> textures;
-    textures.reserve(cgltf_data->textures_count);
+    textures.reserve(selection->textures.kept.size());
 
-    for (uint32_t i = 0; i < cgltf_data->textures_count; i++) {
+    for (uint32_t texture_index : selection->textures.kept) {
         GltfTexture texture{};
 
-        const cgltf_texture* gltf_texture = &cgltf_data->textures[i];
-        if (gltf_texture->image) {
-            texture.image_index = gltf_texture->image - cgltf_data->images;
+        const cgltf_texture* gltf_texture = &cgltf_data->textures[texture_index];
+        if (const cgltf_image* image = get_texture_image(gltf_texture)) {
+            texture.image_index = selection->images.asset_index[image - cgltf_data->images];
         }
 
         if (gltf_texture->sampler) {
-            texture.sampler_index = gltf_texture->sampler - cgltf_data->samplers;
+            texture.sampler_index = selection->samplers.asset_index[gltf_texture->sampler - cgltf_data->samplers];
         }
 
         textures.push_back(texture);
@@ -1055,18 +2531,31 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
     return textures;
 }
 
-[[nodiscard]] static std::vector<GltfScene> load_gltf_scenes(const cgltf_data* cgltf_data) {
+// a node filter replaces the file's scenes with a single scene whose roots are the filtered nodes
+[[nodiscard]] static std::vector<GltfScene> load_gltf_scenes(const LoadOptions* load_options, const cgltf_data* cgltf_data,
+                                                             const LoadSelection* selection) {
     std::vector<GltfScene> scenes;
-    scenes.reserve(cgltf_data->scenes_count);
 
-    for (uint32_t i = 0; i < cgltf_data->scenes_count; i++) {
-        const cgltf_scene* gltf_scene = &cgltf_data->scenes[i];
+    if (!load_options->node_filter.empty()) {
+        GltfScene scene{};
+        scene.nodes.reserve(load_options->node_filter.size());
+        for (uint32_t node_index : load_options->node_filter) {
+            scene.nodes.push_back(selection->nodes.asset_index[node_index]);
+        }
+        scenes.push_back(scene);
+        return scenes;
+    }
+
+    scenes.reserve(selection->scenes.kept.size());
+
+    for (uint32_t scene_index : selection->scenes.kept) {
+        const cgltf_scene* gltf_scene = &cgltf_data->scenes[scene_index];
 
         GltfScene scene{};
         scene.nodes.reserve(gltf_scene->nodes_count);
 
         for (uint32_t j = 0; j < gltf_scene->nodes_count; j++) {
-            scene.nodes.push_back(gltf_scene->nodes[i] - cgltf_data->nodes);
+            scene.nodes.push_back(selection->nodes.asset_index[gltf_scene->nodes[j] - cgltf_data->nodes]);
         }
 
         scenes.push_back(scene);
@@ -1075,12 +2564,12 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
     return scenes;
 }
 
-[[nodiscard]] static std::vector<GltfLight> load_gltf_lights_ext(const cgltf_data* cgltf_data) {
+[[nodiscard]] static std::vector<GltfLight> load_gltf_lights_ext(const cgltf_data* cgltf_data, const LoadSelection* selection) {
     std::vector<GltfLight> lights;
-    lights.reserve(cgltf_data->lights_count);
+    lights.reserve(selection->lights.kept.size());
 
-    for (uint32_t i = 0; i < cgltf_data->lights_count; i++) {
-        const cgltf_light* gltf_light = &cgltf_data->lights[i];
+    for (uint32_t light_index : selection->lights.kept) {
+        const cgltf_light* gltf_light = &cgltf_data->lights[light_index];
 
         GltfLight light{};
         light.range            = gltf_light->range;
@@ -1098,7 +2587,57 @@ static void allocate_staging_buffer(VmaAllocator allocator, uint64_t data_size,
     return lights;
 }
 
-GltfAsset load_gltf(const LoadOptions* load_options, VmaAllocator allocator, VkDevice device, VkCommandPool command_pool, VkQueue queue) {
+[[nodiscard]] static TextureFormatSupport query_texture_format_support(VkPhysicalDevice physical_device) {
+    TextureFormatSupport format_support{};
+    format_support.bc7       = is_texture_format_supported(physical_device, VK_FORMAT_BC7_UNORM_BLOCK) &&
+                         is_texture_format_supported(physical_device, VK_FORMAT_BC7_SRGB_BLOCK);
+    format_support.bc5       = is_texture_format_supported(physical_device, VK_FORMAT_BC5_UNORM_BLOCK);
+    format_support.bc4       = is_texture_format_supported(physical_device, VK_FORMAT_BC4_UNORM_BLOCK);
+    format_support.astc_4x4  = is_texture_format_supported(physical_device, VK_FORMAT_ASTC_4x4_UNORM_BLOCK) &&
+                              is_texture_format_supported(physical_device, VK_FORMAT_ASTC_4x4_SRGB_BLOCK);
+    format_support.etc2_rgba = is_texture_format_supported(physical_device, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK) &&
+                               is_texture_format_supported(physical_device, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK);
+    format_support.eac_rg11  = is_texture_format_supported(physical_device, VK_FORMAT_EAC_R11G11_UNORM_BLOCK);
+    format_support.eac_r11   = is_texture_format_supported(physical_device, VK_FORMAT_EAC_R11_UNORM_BLOCK);
+
+    return format_support;
+}
+
+LoaderContext loader_context_create(VmaAllocator allocator, VkDevice device, VkCommandPool command_pool, VkQueue queue, uint64_t staging_ring_size,
+                                    std::mutex* queue_mutex) {
+    VmaAllocatorInfo allocator_info;
+    vmaGetAllocatorInfo(allocator, &allocator_info);
+    VkPhysicalDeviceProperties physical_device_properties;
+    vkGetPhysicalDeviceProperties(allocator_info.physicalDevice, &physical_device_properties);
+
+    LoaderContext loader_context{};
+    loader_context.allocator                     = allocator;
+    loader_context.device                        = device;
+    loader_context.command_pool                  = command_pool;
+    loader_context.queue                         = queue;
+    loader_context.queue_mutex                   = queue_mutex;
+    loader_context.format_support                = query_texture_format_support(allocator_info.physicalDevice);
+    loader_context.device_max_sampler_anisotropy = physical_device_properties.limits.maxSamplerAnisotropy;
+    loader_context.staging_ring                  = staging_ring_create(allocator, device, command_pool, queue, staging_ring_size, queue_mutex);
+
+    return loader_context;
+}
+
+void loader_context_destroy(LoaderContext* loader_context) {
+    staging_ring_destroy(loader_context->staging_ring);
+    for (const GeometryArena& arena : loader_context->geometry_arenas) {
+        vmaDestroyBuffer(loader_context->allocator, arena.buffer.buffer, arena.buffer.allocation);
+    }
+    for (const CachedSampler& cached_sampler : loader_context->samplers) {
+        if (cached_sampler.ref_count > 0) {
+            vkDestroySampler(loader_context->device, cached_sampler.sampler, nullptr);
+        }
+    }
+    *loader_context = {};
+}
+
+// load_tracker is null for synchronous loads. a cancelled load stops after the stage it noticed in, and returns what it created so far
+[[nodiscard]] static GltfAsset load_gltf_tracked(const LoadOptions* load_options, LoaderContext* loader_context, LoadTracker* load_tracker) {
     cgltf_options options{};
     cgltf_data*   gltf_data = nullptr;
 
@@ -1120,26 +2659,346 @@ GltfAsset load_gltf(const LoadOptions* load_options, VmaAllocator allocator, VkD
         abort_message(message);
     }
 
-    GltfBuffer staging_buffer{};
+    GltfAsset  gltf_asset{};
+    LoadStats* load_stats = &gltf_asset.load_stats;
 
-    GltfAsset gltf_asset{};
-    gltf_asset.images    = load_gltf_images(load_options, gltf_data, device, allocator, command_pool, queue, &staging_buffer);
-    gltf_asset.meshes    = load_gltf_meshes(gltf_data, device, queue, command_pool, allocator, &staging_buffer);
-    gltf_asset.samplers  = load_gltf_samplers(gltf_data, device);
-    gltf_asset.materials = load_gltf_materials(gltf_data);
-    gltf_asset.textures  = load_gltf_textures(gltf_data);
-    gltf_asset.nodes     = load_gltf_nodes(gltf_data);
-    gltf_asset.scenes    = load_gltf_scenes(gltf_data);
+    loader_context->staging_ring->load_stats = load_stats;
 
-    // EXTENSIONS
-    gltf_asset.lights = load_gltf_lights_ext(gltf_data);
+    const LoadSelection selection = get_load_selection(load_options, gltf_data);
+
+    if (load_tracker) {
+        load_tracker->image_count = static_cast<uint32_t>(selection.images.kept.size());
+        load_tracker->mesh_count  = static_cast<uint32_t>(selection.meshes.kept.size());
+    }
+
+    // the images' worker pool writes the geometry too, unless it is still busy encoding streamed full chains
+    set_load_stage(load_tracker, LoadStage::images);
+    WorkerPool* worker_pool = nullptr;
+    gltf_asset.images       = load_gltf_images(load_options, gltf_data, &selection, loader_context, load_stats, &gltf_asset.texture_streamer,
+                                               &worker_pool, load_tracker);
+    if (!is_load_cancelled(load_tracker)) {
+        set_load_stage(load_tracker, LoadStage::meshes);
+        if (worker_pool == nullptr) {
+            worker_pool = worker_pool_create(get_streaming_geometry_thread_count(load_options));
+        }
+        gltf_asset.meshes = load_gltf_meshes(load_options, gltf_data, &selection, loader_context, load_stats, worker_pool, load_tracker);
+    }
+    if (worker_pool) {
+        worker_pool_destroy(worker_pool);
+    }
+    if (!is_load_cancelled(load_tracker)) {
+        gltf_asset.samplers  = load_gltf_samplers(gltf_data, &selection, loader_context);
+        gltf_asset.materials = load_gltf_materials(gltf_data, &selection);
+        gltf_asset.textures  = load_gltf_textures(gltf_data, &selection);
+        gltf_asset.nodes     = load_gltf_nodes(gltf_data, &selection);
+        gltf_asset.scenes    = load_gltf_scenes(load_options, gltf_data, &selection);
 
-    if (staging_buffer.allocation_info.size > 0) {
-        vmaDestroyBuffer(allocator, staging_buffer.buffer, staging_buffer.allocation);
+        // EXTENSIONS
+        gltf_asset.lights = load_gltf_lights_ext(gltf_data, &selection);
     }
+
+    // every upload recorded above is submitted here, and the asset is ready to use once this returns. streamed images start out with only
+    // their tail levels
+    set_load_stage(load_tracker, LoadStage::uploading);
+    staging_ring_wait_idle(loader_context->staging_ring);
+    loader_context->staging_ring->load_stats = nullptr;
+
     cgltf_free(gltf_data);
 
     return gltf_asset;
 }
 
-} // namespace vk_gltf
\ No newline at end of file
+GltfAsset load_gltf(const LoadOptions* load_options, LoaderContext* loader_context) {
+    return load_gltf_tracked(load_options, loader_context, nullptr);
+}
+
+std::vector<TextureUpgrade> poll_texture_streaming(GltfAsset* gltf_asset, LoaderContext* loader_context) {
+    TextureStreamer* streamer = gltf_asset->texture_streamer;
+    if (streamer == nullptr) {
+        return {};
+    }
+    StagingRing* ring = loader_context->staging_ring;
+    ring->load_stats  = &gltf_asset->load_stats;
+
+    // record the full chains that finished encoding until the upload budget is used up
+    std::vector<uint32_t>& pending_images = streamer->pending_images;
+    const size_t           first_upload   = streamer->uploads.size();
+    uint64_t               recorded_bytes = 0;
+    for (size_t i = 0; i < pending_images.size();) {
+        if (streamer->upload_budget > 0 && recorded_bytes >= streamer->upload_budget) {
+            break;
+        }
+        ImageLoadJob* job = &streamer->jobs[pending_images[i]];
+        if (job->ready.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            i++;
+            continue;
+        }
+
+        const uint64_t bytes_uploaded = gltf_asset->load_stats.texture_bytes_uploaded;
+        StreamedUpload upload{};
+        upload.image_index = job->image_index;
+        upload.image       = upload_compressed_job(job, 0, loader_context, &gltf_asset->load_stats);
+        recorded_bytes += gltf_asset->load_stats.texture_bytes_uploaded - bytes_uploaded;
+        release_compressed_job(job);
+
+        streamer->uploads.push_back(upload);
+        pending_images.erase(pending_images.begin() + static_cast<ptrdiff_t>(i));
+    }
+    if (streamer->uploads.size() > first_upload) {
+        staging_ring_flush(ring);
+        for (size_t i = first_upload; i < streamer->uploads.size(); i++) {
+            streamer->uploads[i].ring_position = ring->head;
+        }
+    }
+    if (pending_images.empty() && streamer->worker_pool) {
+        // every full chain has been encoded
+        worker_pool_destroy(streamer->worker_pool);
+        streamer->worker_pool = nullptr;
+    }
+
+    // swap in the full chains whose uploads have completed
+    staging_ring_retire_completed(ring);
+    ring->load_stats = nullptr;
+
+    std::vector<TextureUpgrade> upgrades;
+    size_t                      completed_count = 0;
+    for (const StreamedUpload& upload : streamer->uploads) {
+        if (ring->tail < upload.ring_position) {
+            break;
+        }
+        TextureUpgrade upgrade{};
+        upgrade.image_index                    = upload.image_index;
+        upgrade.retired_image                  = gltf_asset->images[upload.image_index];
+        gltf_asset->images[upload.image_index] = upload.image;
+        upgrades.push_back(upgrade);
+        completed_count++;
+
+        // duplicates share the image, and keep their own usage
+        for (const ImageLoadJob& job : streamer->jobs) {
+            if (job.duplicate_of == upload.image_index) {
+                TextureUpgrade duplicate_upgrade{};
+                duplicate_upgrade.image_index = job.image_index;
+                upgrades.push_back(duplicate_upgrade);
+
+                gltf_asset->images[job.image_index]       = upload.image;
+                gltf_asset->images[job.image_index].usage = job.usage;
+            }
+        }
+    }
+    streamer->uploads.erase(streamer->uploads.begin(), streamer->uploads.begin() + static_cast<ptrdiff_t>(completed_count));
+
+    return upgrades;
+}
+
+bool is_texture_streaming_done(const GltfAsset* gltf_asset) {
+    const TextureStreamer* streamer = gltf_asset->texture_streamer;
+    return streamer == nullptr || (streamer->pending_images.empty() && streamer->uploads.empty());
+}
+
+void stop_texture_streaming(GltfAsset* gltf_asset, LoaderContext* loader_context) {
+    TextureStreamer* streamer = gltf_asset->texture_streamer;
+    if (streamer == nullptr) {
+        return;
+    }
+
+    streamer->cancelled = true;
+    if (streamer->worker_pool) {
+        worker_pool_destroy(streamer->worker_pool);
+    }
+    for (uint32_t image_index : streamer->pending_images) {
+        release_compressed_job(&streamer->jobs[image_index]);
+    }
+
+    // full chains that were recorded but not swapped in yet are dropped, since the caller never sees them
+    staging_ring_wait_idle(loader_context->staging_ring);
+    for (const StreamedUpload& upload : streamer->uploads) {
+        destroy_image(loader_context, &upload.image);
+    }
+
+    delete streamer;
+    gltf_asset->texture_streamer = nullptr;
+}
+
+void unload_gltf(GltfAsset* gltf_asset, LoaderContext* loader_context) {
+    stop_texture_streaming(gltf_asset, loader_context);
+
+    // duplicate images of the asset share one GltfImage, so images the asset owns are only destroyed once
+    std::unordered_set<VkImage> destroyed_images;
+    for (const GltfImage& image : gltf_asset->images) {
+        if (image.image == VK_NULL_HANDLE) {
+            continue;
+        }
+        if (image.share_key != 0) {
+            SharedImage* shared_image = &loader_context->shared_images.at(image.share_key);
+            if (--shared_image->ref_count > 0) {
+                continue;
+            }
+            loader_context->shared_images.erase(image.share_key);
+        }
+        if (destroyed_images.insert(image.image).second) {
+            destroy_image(loader_context, &image);
+        }
+    }
+
+    for (const GltfMesh& mesh : gltf_asset->meshes) {
+        for (const GltfPrimitive& primitive : mesh.primitives) {
+            if (primitive.geometry_arena.has_value()) {
+                continue;
+            }
+            if (primitive.index_buffer.has_value()) {
+                vmaDestroyBuffer(loader_context->allocator, primitive.index_buffer->buffer, primitive.index_buffer->allocation);
+            }
+            vmaDestroyBuffer(loader_context->allocator, primitive.vertex_buffer.buffer, primitive.vertex_buffer.allocation);
+            if (primitive.position_buffer.has_value()) {
+                vmaDestroyBuffer(loader_context->allocator, primitive.position_buffer->buffer, primitive.position_buffer->allocation);
+            }
+        }
+    }
+
+    for (uint32_t sampler_index : gltf_asset->samplers) {
+        release_sampler(loader_context, sampler_index);
+    }
+
+    *gltf_asset = {};
+}
+
+// an asset loading on its own thread into a loader context of its own. the context shares the device, allocator and queue of the caller's, and
+// has its own command pool and staging ring
+struct AsyncLoad {
+    LoadOptions       load_options{};
+    LoaderContext     loader_context{};
+    LoadTracker       load_tracker{};
+    GltfAsset         gltf_asset{};
+    std::thread       thread{};
+    std::future<void> finished{};
+};
+
+// move the samplers, shared images and geometry arenas the load created into the caller's context, and point the asset at them
+static void merge_async_load(AsyncLoad* async_load, LoaderContext* loader_context) {
+    LoaderContext* load_context = &async_load->loader_context;
+    GltfAsset*     gltf_asset   = &async_load->gltf_asset;
+
+    // samplers the caller's context already has take over the load's references, and the load's duplicates are destroyed
+    std::vector<uint32_t> sampler_indices(load_context->samplers.size());
+    for (uint32_t i = 0; i < load_context->samplers.size(); i++) {
+        const CachedSampler* cached_sampler = &load_context->samplers[i];
+        if (cached_sampler->ref_count == 0) {
+            continue;
+        }
+        const std::optional<uint32_t> sampler_index = find_cached_sampler(loader_context, &cached_sampler->create_info);
+        if (sampler_index.has_value()) {
+            loader_context->samplers[sampler_index.value()].ref_count += cached_sampler->ref_count;
+            vkDestroySampler(loader_context->device, cached_sampler->sampler, nullptr);
+            sampler_indices[i] = sampler_index.value();
+        } else {
+            sampler_indices[i] = insert_cached_sampler(loader_context, cached_sampler);
+        }
+    }
+    for (uint32_t& sampler_index : gltf_asset->samplers) {
+        sampler_index = sampler_indices[sampler_index];
+    }
+    load_context->samplers = {};
+
+    // images another load registered in the meantime stay owned by this asset
+    for (auto& [share_key, shared_image] : load_context->shared_images) {
+        if (!loader_context->shared_images.try_emplace(share_key, shared_image).second) {
+            for (GltfImage& image : gltf_asset->images) {
+                if (image.share_key == share_key) {
+                    image.share_key = 0;
+                }
+            }
+        }
+    }
+    load_context->shared_images = {};
+
+    const uint32_t first_arena = static_cast<uint32_t>(loader_context->geometry_arenas.size());
+    loader_context->geometry_arenas.insert(loader_context->geometry_arenas.end(), load_context->geometry_arenas.begin(),
+                                           load_context->geometry_arenas.end());
+    for (GltfMesh& mesh : gltf_asset->meshes) {
+        for (GltfPrimitive& primitive : mesh.primitives) {
+            if (primitive.geometry_arena.has_value()) {
+                primitive.geometry_arena = primitive.geometry_arena.value() + first_arena;
+            }
+        }
+    }
+    load_context->geometry_arenas = {};
+}
+
+AsyncLoad* load_gltf_async(const LoadOptions* load_options, LoaderContext* loader_context, uint32_t queue_family_index) {
+    AsyncLoad* async_load    = new AsyncLoad{};
+    async_load->load_options = *load_options;
+
+    LoaderContext* load_context                 = &async_load->loader_context;
+    load_context->allocator                     = loader_context->allocator;
+    load_context->device                        = loader_context->device;
+    load_context->queue                         = loader_context->queue;
+    load_context->queue_mutex                   = loader_context->queue_mutex;
+    load_context->format_support                = loader_context->format_support;
+    load_context->geometry_arena_size           = loader_context->geometry_arena_size;
+    load_context->max_sampler_anisotropy        = loader_context->max_sampler_anisotropy;
+    load_context->sampler_lod_bias              = loader_context->sampler_lod_bias;
+    load_context->device_max_sampler_anisotropy = loader_context->device_max_sampler_anisotropy;
+
+    // the staging ring allocates a command buffer per submission and frees it once the submission completes
+    const VkCommandPoolCreateInfo command_pool_ci = vk_lib::command_pool_create_info(queue_family_index, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+    VK_CHECK(vkCreateCommandPool(load_context->device, &command_pool_ci, nullptr, &load_context->command_pool));
+    load_context->staging_ring = staging_ring_create(load_context->allocator, load_context->device, load_context->command_pool, load_context->queue,
+                                                     loader_context->staging_ring->size, load_context->queue_mutex);
+
+    std::promise<void> finished;
+    async_load->finished = finished.get_future();
+    async_load->thread   = std::thread([async_load, finished = std::move(finished)]() mutable {
+        LoadTracker* load_tracker = &async_load->load_tracker;
+        async_load->gltf_asset    = load_gltf_tracked(&async_load->load_options, &async_load->loader_context, load_tracker);
+        if (is_load_cancelled(load_tracker)) {
+            // the load waited for its uploads before returning, so nothing it created is in use anymore
+            unload_gltf(&async_load->gltf_asset, &async_load->loader_context);
+            set_load_stage(load_tracker, LoadStage::cancelled);
+        } else {
+            set_load_stage(load_tracker, LoadStage::finished);
+        }
+        finished.set_value();
+    });
+
+    return async_load;
+}
+
+LoadProgress get_load_progress(const AsyncLoad* async_load) {
+    const LoadTracker* load_tracker = &async_load->load_tracker;
+
+    LoadProgress progress{};
+    progress.stage          = load_tracker->stage;
+    progress.images_loaded  = load_tracker->images_loaded;
+    progress.image_count    = load_tracker->image_count;
+    progress.meshes_loaded  = load_tracker->meshes_loaded;
+    progress.mesh_count     = load_tracker->mesh_count;
+    progress.bytes_uploaded = load_tracker->bytes_uploaded;
+
+    return progress;
+}
+
+bool is_load_finished(const AsyncLoad* async_load) {
+    return async_load->finished.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+void cancel_load(AsyncLoad* async_load) { async_load->load_tracker.cancelled = true; }
+
+std::optional<GltfAsset> finish_load(AsyncLoad* async_load, LoaderContext* loader_context) {
+    async_load->thread.join();
+
+    std::optional<GltfAsset> gltf_asset = std::nullopt;
+    if (async_load->load_tracker.stage == LoadStage::finished) {
+        merge_async_load(async_load, loader_context);
+        gltf_asset = std::move(async_load->gltf_asset);
+    }
+
+    // only the staging ring is left in the load's context, and the command buffers it allocated are freed with it
+    const VkCommandPool command_pool = async_load->loader_context.command_pool;
+    loader_context_destroy(&async_load->loader_context);
+    vkDestroyCommandPool(loader_context->device, command_pool, nullptr);
+    delete async_load;
+
+    return gltf_asset;
+}
+
+} // namespace vk_gltf
@@ -0,0 +1,103 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vk_gltf {
+
+#ifdef _WIN32
+
+bool mapped_file_open(const std::string& path, MappedFile* mapped_file) {
+    HANDLE file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file_handle);
+        return false;
+    }
+
+    HANDLE mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+        CloseHandle(file_handle);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        return false;
+    }
+
+    mapped_file->data           = static_cast<const uint8_t*>(data);
+    mapped_file->size           = static_cast<uint64_t>(file_size.QuadPart);
+    mapped_file->file_handle    = file_handle;
+    mapped_file->mapping_handle = mapping_handle;
+
+    return true;
+}
+
+void mapped_file_close(MappedFile* mapped_file) {
+    if (mapped_file->data != nullptr) {
+        UnmapViewOfFile(mapped_file->data);
+        CloseHandle(mapped_file->mapping_handle);
+        CloseHandle(mapped_file->file_handle);
+    }
+    *mapped_file = {};
+}
+
+#else
+
+bool mapped_file_open(const std::string& path, MappedFile* mapped_file) {
+    const int file_descriptor = open(path.c_str(), O_RDONLY);
+    if (file_descriptor < 0) {
+        return false;
+    }
+
+    struct stat file_stat {};
+    if (fstat(file_descriptor, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(file_descriptor);
+        return false;
+    }
+
+    void* data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+    if (data == MAP_FAILED) {
+        close(file_descriptor);
+        return false;
+    }
+    // levels are copied out front to back exactly once
+    madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+
+    mapped_file->data            = static_cast<const uint8_t*>(data);
+    mapped_file->size            = static_cast<uint64_t>(file_stat.st_size);
+    mapped_file->file_descriptor = file_descriptor;
+
+    return true;
+}
+
+void mapped_file_close(MappedFile* mapped_file) {
+    if (mapped_file->data != nullptr) {
+        munmap(const_cast<uint8_t*>(mapped_file->data), mapped_file->size);
+        close(mapped_file->file_descriptor);
+    }
+    *mapped_file = {};
+}
+
+#endif
+
+} // namespace vk_gltf
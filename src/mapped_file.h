@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace vk_gltf {
+
+// read only memory mapping of a whole file
+struct MappedFile {
+    const uint8_t* data{};
+    uint64_t       size{};
+#ifdef _WIN32
+    void* file_handle{};
+    void* mapping_handle{};
+#else
+    int file_descriptor{-1};
+#endif
+};
+
+// returns false if the file cannot be opened or mapped
+[[nodiscard]] bool mapped_file_open(const std::string& path, MappedFile* mapped_file);
+
+void mapped_file_close(MappedFile* mapped_file);
+
+} // namespace vk_gltf
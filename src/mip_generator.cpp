@@ -0,0 +1,242 @@
+#include "mip_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(__AVX2__)
+#include <immintrin.h>
+#define VK_GLTF_MIP_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define VK_GLTF_MIP_NEON
+#endif
+
+namespace vk_gltf {
+
+// rows are filtered as 4 floats per texel whatever the channel count, so a texel always fills one simd register
+constexpr uint32_t working_channels = 4;
+
+// half width of the kaiser kernel in source texels. 6 taps per axis
+constexpr uint32_t kaiser_radius = 3;
+constexpr float    kaiser_alpha  = 4.f;
+
+constexpr float pi = 3.14159265358979f;
+
+struct ConversionTables {
+    // 8 bit value -> linear float
+    float srgb_to_linear[256];
+    float unorm_to_float[256];
+    // linear values at which the srgb encoding rounds up to the next 8 bit value
+    float srgb_thresholds[255];
+};
+
+static float srgb_decode(float value) { return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f); }
+
+static const ConversionTables* get_conversion_tables() {
+    static const ConversionTables tables = [] {
+        ConversionTables new_tables{};
+        for (uint32_t i = 0; i < 256; i++) {
+            new_tables.srgb_to_linear[i] = srgb_decode(i / 255.f);
+            new_tables.unorm_to_float[i] = i / 255.f;
+        }
+        for (uint32_t i = 0; i < 255; i++) {
+            new_tables.srgb_thresholds[i] = srgb_decode((i + 0.5f) / 255.f);
+        }
+        return new_tables;
+    }();
+    return &tables;
+}
+
+static double bessel_i0(double x) {
+    double sum  = 1.0;
+    double term = 1.0;
+    for (uint32_t k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// weights of the taps that produce one destination texel, normalized to sum to one. tap t reads the source texel at 2 * x - radius + 1 + t
+static std::vector<float> get_filter_weights(MipFilter filter) {
+    if (filter == MipFilter::box) {
+        return {0.5f, 0.5f};
+    }
+
+    std::vector<float> weights(kaiser_radius * 2);
+    float              weight_sum = 0.f;
+    for (uint32_t t = 0; t < weights.size(); t++) {
+        // distance of the tap from the destination texel center, in source texels
+        const double distance = static_cast<double>(t) - kaiser_radius + 0.5;
+        // low pass at the destination nyquist frequency, windowed to the kernel radius
+        const double sinc_x = distance / 2.0;
+        const double sinc   = sinc_x == 0.0 ? 1.0 : std::sin(pi * sinc_x) / (pi * sinc_x);
+        const double ratio  = distance / kaiser_radius;
+        const double window = bessel_i0(kaiser_alpha * std::sqrt(std::max(1.0 - ratio * ratio, 0.0))) / bessel_i0(kaiser_alpha);
+
+        weights[t] = static_cast<float>(sinc * window);
+        weight_sum += weights[t];
+    }
+    for (float& weight : weights) {
+        weight /= weight_sum;
+    }
+    return weights;
+}
+
+static void linearize_row(const uint8_t* src, uint32_t width, uint32_t channel_count, bool srgb, float* dst) {
+    const ConversionTables* tables = get_conversion_tables();
+    for (uint32_t x = 0; x < width; x++) {
+        for (uint32_t c = 0; c < working_channels; c++) {
+            if (c >= channel_count) {
+                dst[x * working_channels + c] = 0.f;
+                continue;
+            }
+            const uint8_t value           = src[x * channel_count + c];
+            const bool    is_color        = srgb && (c < 3);
+            dst[x * working_channels + c] = is_color ? tables->srgb_to_linear[value] : tables->unorm_to_float[value];
+        }
+    }
+}
+
+static void encode_row(const float* src, uint32_t width, uint32_t channel_count, bool srgb, uint8_t* dst) {
+    const ConversionTables* tables = get_conversion_tables();
+    for (uint32_t x = 0; x < width; x++) {
+        for (uint32_t c = 0; c < channel_count; c++) {
+            // sharper filters overshoot, so clamp before quantizing
+            const float value = std::clamp(src[x * working_channels + c], 0.f, 1.f);
+            if (srgb && c < 3) {
+                const float* threshold         = std::upper_bound(tables->srgb_thresholds, tables->srgb_thresholds + 255, value);
+                dst[x * channel_count + c] = static_cast<uint8_t>(threshold - tables->srgb_thresholds);
+            } else {
+                dst[x * channel_count + c] = static_cast<uint8_t>(value * 255.f + 0.5f);
+            }
+        }
+    }
+}
+
+// downsample one row of linear texels by 2 horizontally
+static void filter_row_horizontal(const float* src, uint32_t src_width, const std::vector<float>& weights, float* dst, uint32_t dst_width) {
+    const int32_t  radius    = static_cast<int32_t>(weights.size() / 2);
+    const uint32_t tap_count = static_cast<uint32_t>(weights.size());
+
+    for (uint32_t x = 0; x < dst_width; x++) {
+        const int32_t first_tap = 2 * static_cast<int32_t>(x) - radius + 1;
+#if defined(VK_GLTF_MIP_SSE)
+        __m128 accumulator = _mm_setzero_ps();
+        for (uint32_t t = 0; t < tap_count; t++) {
+            const int32_t src_x = std::clamp(first_tap + static_cast<int32_t>(t), 0, static_cast<int32_t>(src_width) - 1);
+            const __m128  texel = _mm_loadu_ps(src + src_x * working_channels);
+#if defined(__FMA__)
+            accumulator = _mm_fmadd_ps(_mm_set1_ps(weights[t]), texel, accumulator);
+#else
+            accumulator = _mm_add_ps(accumulator, _mm_mul_ps(_mm_set1_ps(weights[t]), texel));
+#endif
+        }
+        _mm_storeu_ps(dst + x * working_channels, accumulator);
+#elif defined(VK_GLTF_MIP_NEON)
+        float32x4_t accumulator = vdupq_n_f32(0.f);
+        for (uint32_t t = 0; t < tap_count; t++) {
+            const int32_t src_x = std::clamp(first_tap + static_cast<int32_t>(t), 0, static_cast<int32_t>(src_width) - 1);
+            accumulator         = vmlaq_n_f32(accumulator, vld1q_f32(src + src_x * working_channels), weights[t]);
+        }
+        vst1q_f32(dst + x * working_channels, accumulator);
+#else
+        float accumulator[working_channels]{};
+        for (uint32_t t = 0; t < tap_count; t++) {
+            const int32_t src_x = std::clamp(first_tap + static_cast<int32_t>(t), 0, static_cast<int32_t>(src_width) - 1);
+            for (uint32_t c = 0; c < working_channels; c++) {
+                accumulator[c] += weights[t] * src[src_x * working_channels + c];
+            }
+        }
+        std::copy_n(accumulator, working_channels, dst + x * working_channels);
+#endif
+    }
+}
+
+// weighted sum of horizontally filtered rows. rows are contiguous floats, so this runs across the full simd width
+static void filter_rows_vertical(const float* const* rows, const std::vector<float>& weights, float* dst, uint32_t float_count) {
+    const uint32_t tap_count = static_cast<uint32_t>(weights.size());
+
+    uint32_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 8 <= float_count; i += 8) {
+        __m256 accumulator = _mm256_setzero_ps();
+        for (uint32_t t = 0; t < tap_count; t++) {
+#if defined(__FMA__)
+            accumulator = _mm256_fmadd_ps(_mm256_set1_ps(weights[t]), _mm256_loadu_ps(rows[t] + i), accumulator);
+#else
+            accumulator = _mm256_add_ps(accumulator, _mm256_mul_ps(_mm256_set1_ps(weights[t]), _mm256_loadu_ps(rows[t] + i)));
+#endif
+        }
+        _mm256_storeu_ps(dst + i, accumulator);
+    }
+#endif
+#if defined(VK_GLTF_MIP_SSE)
+    for (; i + 4 <= float_count; i += 4) {
+        __m128 accumulator = _mm_setzero_ps();
+        for (uint32_t t = 0; t < tap_count; t++) {
+            accumulator = _mm_add_ps(accumulator, _mm_mul_ps(_mm_set1_ps(weights[t]), _mm_loadu_ps(rows[t] + i)));
+        }
+        _mm_storeu_ps(dst + i, accumulator);
+    }
+#elif defined(VK_GLTF_MIP_NEON)
+    for (; i + 4 <= float_count; i += 4) {
+        float32x4_t accumulator = vdupq_n_f32(0.f);
+        for (uint32_t t = 0; t < tap_count; t++) {
+            accumulator = vmlaq_n_f32(accumulator, vld1q_f32(rows[t] + i), weights[t]);
+        }
+        vst1q_f32(dst + i, accumulator);
+    }
+#endif
+    for (; i < float_count; i++) {
+        float accumulator = 0.f;
+        for (uint32_t t = 0; t < tap_count; t++) {
+            accumulator += weights[t] * rows[t][i];
+        }
+        dst[i] = accumulator;
+    }
+}
+
+// halve src into dst. only the source rows under the kernel are kept in linear form at any time, so memory use stays a few rows no matter the
+// image size
+static void generate_mip_level(const MipLevel* src, const MipLevel* dst, uint32_t channel_count, bool srgb, const std::vector<float>& weights) {
+    const uint32_t tap_count = static_cast<uint32_t>(weights.size());
+    const int32_t  radius    = static_cast<int32_t>(tap_count / 2);
+    const uint32_t row_floats = dst->width * working_channels;
+
+    // horizontally filtered source rows, indexed by source row modulo the tap count. consecutive destination rows share tap_count - 2 of them
+    std::vector<float>   filtered_rows(tap_count * row_floats);
+    std::vector<int32_t> filtered_row_index(tap_count, -1);
+    std::vector<float>   linear_row(src->width * working_channels);
+    std::vector<float>   dst_row(row_floats);
+
+    std::vector<const float*> tap_rows(tap_count);
+    for (uint32_t y = 0; y < dst->height; y++) {
+        const int32_t first_tap = 2 * static_cast<int32_t>(y) - radius + 1;
+        for (uint32_t t = 0; t < tap_count; t++) {
+            const int32_t src_y = std::clamp(first_tap + static_cast<int32_t>(t), 0, static_cast<int32_t>(src->height) - 1);
+            const int32_t slot  = src_y % static_cast<int32_t>(tap_count);
+            float*        row   = filtered_rows.data() + slot * row_floats;
+            if (filtered_row_index[slot] != src_y) {
+                linearize_row(src->data + static_cast<uint64_t>(src_y) * src->width * channel_count, src->width, channel_count, srgb,
+                              linear_row.data());
+                filter_row_horizontal(linear_row.data(), src->width, weights, row, dst->width);
+                filtered_row_index[slot] = src_y;
+            }
+            tap_rows[t] = row;
+        }
+
+        filter_rows_vertical(tap_rows.data(), weights, dst_row.data(), row_floats);
+        encode_row(dst_row.data(), dst->width, channel_count, srgb, dst->data + static_cast<uint64_t>(y) * dst->width * channel_count);
+    }
+}
+
+void generate_mip_chain(const MipLevel* levels, uint32_t level_count, uint32_t channel_count, bool srgb, MipFilter filter) {
+    const std::vector<float> weights = get_filter_weights(filter);
+    for (uint32_t level = 1; level < level_count; level++) {
+        generate_mip_level(&levels[level - 1], &levels[level], channel_count, srgb, weights);
+    }
+}
+
+} // namespace vk_gltf
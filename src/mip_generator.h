@@ -0,0 +1,20 @@
+#pragma once
+
+#include "vk_gltf/loader.h"
+
+#include <cstdint>
+
+namespace vk_gltf {
+
+// a mip level of tightly packed 8 bit texels
+struct MipLevel {
+    uint8_t* data{};
+    uint32_t width{};
+    uint32_t height{};
+};
+
+// fill levels [1, level_count) by repeatedly halving the level before them, starting from the image in levels[0]. when srgb is set, every
+// channel but a fourth alpha channel is converted to linear before filtering and back to srgb after
+void generate_mip_chain(const MipLevel* levels, uint32_t level_count, uint32_t channel_count, bool srgb, MipFilter filter);
+
+} // namespace vk_gltf
@@ -0,0 +1,313 @@
+#include "staging_ring.h"
+
+#include "utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(__AVX2__)
+#include <immintrin.h>
+#define VK_GLTF_STAGING_SSE
+#endif
+
+namespace vk_gltf {
+
+// keeps every allocation float aligned, and is a multiple of every block size we upload
+constexpr uint64_t staging_alignment = 16;
+
+StagingRing* staging_ring_create(VmaAllocator allocator, VkDevice device, VkCommandPool command_pool, VkQueue queue, uint64_t size,
+                                 std::mutex* queue_mutex) {
+    StagingRing* ring  = new StagingRing{};
+    ring->allocator    = allocator;
+    ring->device       = device;
+    ring->command_pool = command_pool;
+    ring->queue        = queue;
+    ring->queue_mutex  = queue_mutex;
+    ring->size         = size;
+
+    const VkBufferCreateInfo staging_buffer_ci = vk_lib::buffer_create_info(VK_BUFFER_USAGE_TRANSFER_SRC_BIT, size);
+    VmaAllocationCreateInfo  allocation_ci{};
+    allocation_ci.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    allocation_ci.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+    VK_CHECK(vmaCreateBuffer(allocator, &staging_buffer_ci, &allocation_ci, &ring->buffer.buffer, &ring->buffer.allocation,
+                             &ring->buffer.allocation_info));
+
+    return ring;
+}
+
+void staging_ring_destroy(StagingRing* ring) {
+    staging_ring_wait_idle(ring);
+
+    for (VkFence fence : ring->free_fences) {
+        vkDestroyFence(ring->device, fence, nullptr);
+    }
+    vmaDestroyBuffer(ring->allocator, ring->buffer.buffer, ring->buffer.allocation);
+
+    delete ring;
+}
+
+// block until the oldest submission completes and release its part of the ring
+static void retire_oldest_submission(StagingRing* ring) {
+    const StagingSubmission submission = ring->in_flight.front();
+    ring->in_flight.pop_front();
+
+    VK_CHECK(vkWaitForFences(ring->device, 1, &submission.fence, true, UINT64_MAX));
+    VK_CHECK(vkResetFences(ring->device, 1, &submission.fence));
+    ring->free_fences.push_back(submission.fence);
+
+    vkFreeCommandBuffers(ring->device, ring->command_pool, 1, &submission.command_buffer);
+
+    ring->tail = submission.end;
+}
+
+// host writes to [start, end) must be flushed before the gpu reads them, in case the memory is not host coherent
+static void flush_ring_range(StagingRing* ring, uint64_t start, uint64_t end) {
+    if (end <= start) {
+        return;
+    }
+    if (end - start >= ring->size) {
+        VK_CHECK(vmaFlushAllocation(ring->allocator, ring->buffer.allocation, 0, VK_WHOLE_SIZE));
+        return;
+    }
+    const uint64_t start_offset = start % ring->size;
+    const uint64_t end_offset   = end % ring->size;
+    if (start_offset < end_offset || end_offset == 0) {
+        VK_CHECK(vmaFlushAllocation(ring->allocator, ring->buffer.allocation, start_offset, end - start));
+    } else {
+        VK_CHECK(vmaFlushAllocation(ring->allocator, ring->buffer.allocation, start_offset, ring->size - start_offset));
+        VK_CHECK(vmaFlushAllocation(ring->allocator, ring->buffer.allocation, 0, end_offset));
+    }
+}
+
+// position the next allocation of size bytes starts at. the alignment applies to the offset into the buffer, which is what copies see. the
+// ring size need not be a multiple of it, as with the 3 byte texels of rgb8 images
+[[nodiscard]] static uint64_t get_allocation_position(const StagingRing* ring, uint64_t size, uint64_t alignment) {
+    const uint64_t lap_start = ring->head - ring->head % ring->size;
+    const uint64_t offset    = align_up(ring->head % ring->size, alignment);
+    // allocations are contiguous, so skip the rest of the buffer if this one would run past its end. offset 0 suits every alignment
+    if (offset + size > ring->size) {
+        return lap_start + ring->size;
+    }
+    return lap_start + offset;
+}
+
+bool staging_ring_fits(const StagingRing* ring, uint64_t size, uint64_t alignment) {
+    return size <= ring->size && get_allocation_position(ring, size, alignment) + size <= ring->tail + ring->size;
+}
+
+uint64_t staging_ring_allocate(StagingRing* ring, uint64_t size, uint64_t alignment, void** mapped_data) {
+    if (size > ring->size) {
+        abort_message("Staging allocation of " + std::to_string(size) + " bytes is larger than the staging ring");
+    }
+
+    const uint64_t position = get_allocation_position(ring, size, alignment);
+
+    // wait for the oldest transfers until the bytes we need are no longer in flight
+    while (position + size > ring->tail + ring->size) {
+        if (ring->in_flight.empty()) {
+            staging_ring_flush(ring);
+        }
+        if (ring->in_flight.empty()) {
+            // nothing references the ring at all
+            ring->tail = position;
+            break;
+        }
+        retire_oldest_submission(ring);
+    }
+
+    ring->head   = position + size;
+    *mapped_data = static_cast<uint8_t*>(ring->buffer.allocation_info.pMappedData) + position % ring->size;
+
+    return position % ring->size;
+}
+
+VkCommandBuffer staging_ring_command_buffer(StagingRing* ring) {
+    if (ring->recording_command_buffer == nullptr) {
+        const VkCommandBufferAllocateInfo command_buffer_ai = vk_lib::command_buffer_allocate_info(ring->command_pool);
+        VK_CHECK(vkAllocateCommandBuffers(ring->device, &command_buffer_ai, &ring->recording_command_buffer));
+
+        const VkCommandBufferBeginInfo command_buffer_bi = vk_lib::command_buffer_begin_info();
+        VK_CHECK(vkBeginCommandBuffer(ring->recording_command_buffer, &command_buffer_bi));
+    }
+
+    return ring->recording_command_buffer;
+}
+
+uint64_t staging_ring_max_chunk_size(const StagingRing* ring) {
+    // a quarter of the ring, so several chunks can be in flight while the next one is written
+    return std::max(ring->size / 4 / staging_alignment * staging_alignment, staging_alignment);
+}
+
+void staging_ring_flush(StagingRing* ring) {
+    if (ring->recording_command_buffer == nullptr) {
+        if (ring->in_flight.empty()) {
+            ring->tail = ring->head;
+        }
+        return;
+    }
+    VkCommandBuffer cmd_buf = ring->recording_command_buffer;
+
+    // make the transferred data visible to everything submitted to the queue after this
+    VkMemoryBarrier2 memory_barrier{};
+    memory_barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    memory_barrier.srcStageMask  = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+    memory_barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    memory_barrier.dstStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    memory_barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+    VkDependencyInfo dependency_info{};
+    dependency_info.sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependency_info.memoryBarrierCount = 1;
+    dependency_info.pMemoryBarriers    = &memory_barrier;
+    vkCmdPipelineBarrier2(cmd_buf, &dependency_info);
+
+    VK_CHECK(vkEndCommandBuffer(cmd_buf));
+
+    const uint64_t submission_start = ring->in_flight.empty() ? ring->tail : ring->in_flight.back().end;
+    flush_ring_range(ring, submission_start, ring->head);
+
+    VkFence fence{};
+    if (ring->free_fences.empty()) {
+        const VkFenceCreateInfo fence_ci = vk_lib::fence_create_info();
+        VK_CHECK(vkCreateFence(ring->device, &fence_ci, nullptr, &fence));
+    } else {
+        fence = ring->free_fences.back();
+        ring->free_fences.pop_back();
+    }
+
+    const VkCommandBufferSubmitInfo command_buffer_submit_info = vk_lib::command_buffer_submit_info(cmd_buf);
+    const VkSubmitInfo2             submit_info_2              = vk_lib::submit_info_2(&command_buffer_submit_info);
+    if (ring->queue_mutex) {
+        std::lock_guard lock(*ring->queue_mutex);
+        VK_CHECK(vkQueueSubmit2(ring->queue, 1, &submit_info_2, fence));
+    } else {
+        VK_CHECK(vkQueueSubmit2(ring->queue, 1, &submit_info_2, fence));
+    }
+
+    if (ring->load_stats) {
+        ring->load_stats->queue_submits++;
+    }
+
+    StagingSubmission submission{};
+    submission.command_buffer = cmd_buf;
+    submission.fence          = fence;
+    submission.end            = ring->head;
+    ring->in_flight.push_back(submission);
+
+    ring->recording_command_buffer = nullptr;
+}
+
+void staging_ring_wait_idle(StagingRing* ring) {
+    staging_ring_flush(ring);
+    while (!ring->in_flight.empty()) {
+        retire_oldest_submission(ring);
+    }
+    ring->tail = ring->head;
+}
+
+void staging_ring_retire_completed(StagingRing* ring) {
+    while (!ring->in_flight.empty()) {
+        const VkResult status = vkGetFenceStatus(ring->device, ring->in_flight.front().fence);
+        if (status == VK_NOT_READY) {
+            return;
+        }
+        VK_CHECK(status);
+        retire_oldest_submission(ring);
+    }
+    if (ring->recording_command_buffer == nullptr) {
+        ring->tail = ring->head;
+    }
+}
+
+void stream_to_staging(void* dst, const void* src, uint64_t size) {
+    uint8_t*       dst_bytes = static_cast<uint8_t*>(dst);
+    const uint8_t* src_bytes = static_cast<const uint8_t*>(src);
+#if defined(VK_GLTF_STAGING_SSE)
+    // plain stores up to the first 16 byte boundary of dst, then streaming stores for every full 16 bytes after it
+    const uint64_t head_size = std::min((16 - reinterpret_cast<uintptr_t>(dst_bytes) % 16) % 16, size);
+    memcpy(dst_bytes, src_bytes, head_size);
+    uint64_t i = head_size;
+    for (; i + 16 <= size; i += 16) {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst_bytes + i), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_bytes + i)));
+    }
+    memcpy(dst_bytes + i, src_bytes + i, size - i);
+    // streaming stores are weakly ordered, so they are fenced before anything can submit a transfer out of them
+    _mm_sfence();
+#else
+    memcpy(dst_bytes, src_bytes, size);
+#endif
+}
+
+void staging_ring_upload_buffer(StagingRing* ring, const void* src, uint64_t size, VkBuffer dst_buffer, uint64_t dst_offset) {
+    const uint8_t* src_bytes  = static_cast<const uint8_t*>(src);
+    const uint64_t chunk_size = staging_ring_max_chunk_size(ring);
+
+    for (uint64_t offset = 0; offset < size; offset += chunk_size) {
+        const uint64_t copy_size = std::min(chunk_size, size - offset);
+
+        void*          mapped_data;
+        const uint64_t staging_offset = staging_ring_allocate(ring, copy_size, staging_alignment, &mapped_data);
+        memcpy(mapped_data, src_bytes + offset, copy_size);
+
+        const VkBufferCopy buffer_copy = vk_lib::buffer_copy(copy_size, staging_offset, dst_offset + offset);
+        vkCmdCopyBuffer(staging_ring_command_buffer(ring), ring->buffer.buffer, dst_buffer, 1, &buffer_copy);
+    }
+}
+
+void staging_ring_upload_image(StagingRing* ring, VkImage image, VkFormat format, const std::vector<ImageLevelUpload>& levels,
+                               VkImageLayout final_layout) {
+    const VkImageSubresourceRange subresource_range = vk_lib::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT, levels.size());
+
+    // TODO: specify more fine grained stage and access flags
+    const VkImageMemoryBarrier2 copy_memory_barrier =
+        vk_lib::image_memory_barrier_2(image, subresource_range, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    const VkDependencyInfo copy_dependency_info = vk_lib::dependency_info(&copy_memory_barrier, nullptr, nullptr);
+    vkCmdPipelineBarrier2(staging_ring_command_buffer(ring), &copy_dependency_info);
+
+    const FormatBlockInfo block_info = get_format_block_info(format);
+    // buffer offsets of image copies must be a multiple of the block size
+    const uint64_t alignment  = std::lcm(staging_alignment, static_cast<uint64_t>(block_info.bytes));
+    const uint64_t chunk_size = staging_ring_max_chunk_size(ring);
+
+    for (uint32_t level = 0; level < levels.size(); level++) {
+        const ImageLevelUpload* level_upload = &levels[level];
+
+        const uint32_t blocks_wide = (level_upload->extent.width + block_info.width - 1) / block_info.width;
+        const uint32_t blocks_high = (level_upload->extent.height + block_info.height - 1) / block_info.height;
+        const uint64_t row_pitch   = static_cast<uint64_t>(blocks_wide) * block_info.bytes;
+        if (row_pitch > chunk_size) {
+            abort_message("A single row of texel blocks does not fit into the staging ring");
+        }
+
+        // whole levels are copied at once when they fit. otherwise they are split into bands of block rows
+        const uint32_t rows_per_chunk = static_cast<uint32_t>(std::min<uint64_t>(chunk_size / row_pitch, blocks_high));
+        for (uint32_t row = 0; row < blocks_high; row += rows_per_chunk) {
+            const uint32_t row_count = std::min(rows_per_chunk, blocks_high - row);
+            const uint64_t copy_size = row_count * row_pitch;
+
+            void*          mapped_data;
+            const uint64_t staging_offset = staging_ring_allocate(ring, copy_size, alignment, &mapped_data);
+            memcpy(mapped_data, level_upload->data + row * row_pitch, copy_size);
+
+            const uint32_t y_offset    = row * block_info.height;
+            const uint32_t band_height = std::min(row_count * block_info.height, level_upload->extent.height - y_offset);
+
+            VkImageSubresourceLayers image_subresource = vk_lib::image_subresource_layers(VK_IMAGE_ASPECT_COLOR_BIT, level);
+            VkExtent3D               band_extent       = vk_lib::extent_3d(level_upload->extent.width, band_height);
+            VkBufferImageCopy        buffer_image_copy = vk_lib::buffer_image_copy(image_subresource, band_extent, staging_offset);
+            buffer_image_copy.imageOffset.y            = static_cast<int32_t>(y_offset);
+
+            vkCmdCopyBufferToImage(staging_ring_command_buffer(ring), ring->buffer.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
+                                   &buffer_image_copy);
+        }
+    }
+
+    // TODO: specify more fine grained stage and access flags
+    const VkImageMemoryBarrier2 texture_use_memory_barrier =
+        vk_lib::image_memory_barrier_2(image, subresource_range, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, final_layout);
+    const VkDependencyInfo texture_use_dependency_info = vk_lib::dependency_info(&texture_use_memory_barrier, nullptr, nullptr);
+    vkCmdPipelineBarrier2(staging_ring_command_buffer(ring), &texture_use_dependency_info);
+}
+
+} // namespace vk_gltf
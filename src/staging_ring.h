@@ -0,0 +1,89 @@
+#pragma once
+
+#include "vk_gltf/loader.h"
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace vk_gltf {
+
+// a command buffer that has been submitted along with the ring position its staging data ends at
+struct StagingSubmission {
+    VkCommandBuffer command_buffer{};
+    VkFence         fence{};
+    uint64_t        end{};
+};
+
+// fixed size host visible buffer that uploads are streamed through. head and tail are monotonically increasing positions, and the ring offset of
+// a position is position % size. bytes in [tail, head) are still referenced by recorded or in flight transfers. writers only stall on a fence when
+// an allocation would overwrite bytes that are still in flight
+struct StagingRing {
+    VmaAllocator  allocator{};
+    VkDevice      device{};
+    VkCommandPool command_pool{};
+    VkQueue       queue{};
+    // locked around submits when the queue is shared with other threads. may be null
+    std::mutex* queue_mutex{};
+
+    GltfBuffer buffer{};
+    uint64_t   size{};
+    uint64_t   head{};
+    uint64_t   tail{};
+
+    // command buffer currently being recorded into. submitted on flush, or when the ring runs out of space
+    VkCommandBuffer               recording_command_buffer{};
+    std::deque<StagingSubmission> in_flight{};
+    std::vector<VkFence>          free_fences{};
+
+    // stats of the load currently using the ring. may be null
+    LoadStats* load_stats{};
+};
+
+[[nodiscard]] StagingRing* staging_ring_create(VmaAllocator allocator, VkDevice device, VkCommandPool command_pool, VkQueue queue, uint64_t size,
+                                              std::mutex* queue_mutex);
+
+// waits for all in flight transfers, then frees the ring
+void staging_ring_destroy(StagingRing* ring);
+
+// reserve size bytes of the ring and return their offset into ring->buffer. size must not exceed the ring size. may submit the recording
+// command buffer and wait on in flight transfers to make room, so fetch the command buffer after allocating
+[[nodiscard]] uint64_t staging_ring_allocate(StagingRing* ring, uint64_t size, uint64_t alignment, void** mapped_data);
+
+// whether staging_ring_allocate can reserve size bytes right away, without submitting the recording command buffer or waiting on transfers
+[[nodiscard]] bool staging_ring_fits(const StagingRing* ring, uint64_t size, uint64_t alignment);
+
+// the command buffer that copies out of the most recent allocations must be recorded into
+[[nodiscard]] VkCommandBuffer staging_ring_command_buffer(StagingRing* ring);
+
+// largest piece the upload helpers stage at once, so that writing one chunk overlaps with the transfer of the previous ones
+[[nodiscard]] uint64_t staging_ring_max_chunk_size(const StagingRing* ring);
+
+// submit the recording command buffer without waiting for it
+void staging_ring_flush(StagingRing* ring);
+
+// submit the recording command buffer and wait until every transfer has completed
+void staging_ring_wait_idle(StagingRing* ring);
+
+// release every submission whose transfers have already completed, without waiting. a position is complete once ring->tail has passed it
+void staging_ring_retire_completed(StagingRing* ring);
+
+// copy size bytes from src to dst_buffer at dst_offset, chunked if the data is larger than the ring
+void staging_ring_upload_buffer(StagingRing* ring, const void* src, uint64_t size, VkBuffer dst_buffer, uint64_t dst_offset);
+
+// copy size bytes into mapped staging memory with non-temporal stores where the cpu has them, so large uploads don't evict the data they are
+// built from. staging memory is often write combined, where full aligned 16 byte stores are the fastest way in as well
+void stream_to_staging(void* dst, const void* src, uint64_t size);
+
+// a tightly packed mip level to upload
+struct ImageLevelUpload {
+    const uint8_t* data{};
+    uint64_t       size{};
+    VkExtent3D     extent{};
+};
+
+// transition image to transfer dst, upload every level (chunked by rows of blocks if needed) and transition it to final_layout
+void staging_ring_upload_image(StagingRing* ring, VkImage image, VkFormat format, const std::vector<ImageLevelUpload>& levels,
+                               VkImageLayout final_layout);
+
+} // namespace vk_gltf
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "vk_gltf/loader.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <vulkan/vk_enum_string_helper.h>
+
+namespace vk_gltf {
+
+[[noreturn]] inline void abort_message(const std::string_view message) {
+    std::cerr << message << std::endl;
+    std::abort();
+}
+
+#define VK_CHECK(x)                                                                                                                                  \
+    do {                                                                                                                                             \
+        VkResult err = x;                                                                                                                            \
+        if (err) {                                                                                                                                   \
+            std::cerr << "Detected Vulkan error: " << string_VkResult(err) << std::endl;                                                             \
+            abort();                                                                                                                                 \
+        }                                                                                                                                            \
+    } while (0)
+
+[[nodiscard]] inline uint64_t align_up(uint64_t value, uint64_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+// dimensions and size in bytes of a texel block. uncompressed formats have 1x1 blocks
+struct FormatBlockInfo {
+    uint32_t width{1};
+    uint32_t height{1};
+    uint32_t bytes{4};
+};
+
+// block info of the formats textures can be uploaded in. that is every format this loader transcodes to, and the formats ktx2 sources
+// already in a gpu format are accepted in. returns false for any other format
+[[nodiscard]] inline bool find_format_block_info(VkFormat format, FormatBlockInfo* block_info) {
+    switch (format) {
+    case VK_FORMAT_R8_UNORM:
+    case VK_FORMAT_R8_SNORM:
+    case VK_FORMAT_R8_SRGB:
+        *block_info = {1, 1, 1};
+        return true;
+    case VK_FORMAT_R8G8_UNORM:
+    case VK_FORMAT_R8G8_SNORM:
+    case VK_FORMAT_R8G8_SRGB:
+    case VK_FORMAT_R16_UNORM:
+    case VK_FORMAT_R16_SNORM:
+    case VK_FORMAT_R16_SFLOAT:
+        *block_info = {1, 1, 2};
+        return true;
+    case VK_FORMAT_R8G8B8_UNORM:
+    case VK_FORMAT_R8G8B8_SNORM:
+    case VK_FORMAT_R8G8B8_SRGB:
+        *block_info = {1, 1, 3};
+        return true;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+    case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+    case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+    case VK_FORMAT_R16G16_UNORM:
+    case VK_FORMAT_R16G16_SNORM:
+    case VK_FORMAT_R16G16_SFLOAT:
+    case VK_FORMAT_R32_SFLOAT:
+        *block_info = {1, 1, 4};
+        return true;
+    case VK_FORMAT_R16G16B16A16_UNORM:
+    case VK_FORMAT_R16G16B16A16_SNORM:
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+    case VK_FORMAT_R32G32_SFLOAT:
+        *block_info = {1, 1, 8};
+        return true;
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+        *block_info = {1, 1, 16};
+        return true;
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+    case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+        *block_info = {4, 4, 8};
+        return true;
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_ASTC_4x4_UNORM_BLOCK:
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+    case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+        *block_info = {4, 4, 16};
+        return true;
+    default:
+        return false;
+    }
+}
+
+// block info of a format that is known to be uploadable. formats are checked with find_format_block_info before they get here
+[[nodiscard]] inline FormatBlockInfo get_format_block_info(VkFormat format) {
+    FormatBlockInfo block_info{};
+    if (!find_format_block_info(format, &block_info)) {
+        abort_message(std::string("Unsupported texture format: ") + string_VkFormat(format));
+    }
+    return block_info;
+}
+
+[[nodiscard]] inline bool is_srgb_format(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_R8G8B8_SRGB:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_ASTC_4x4_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace vk_gltf
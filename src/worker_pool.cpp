@@ -0,0 +1,68 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace vk_gltf {
+
+static void worker_loop(WorkerPool* pool) {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock lock(pool->mutex);
+            pool->job_available.wait(lock, [pool] { return pool->stopping || !pool->jobs.empty(); });
+            if (pool->jobs.empty()) {
+                // only reachable when stopping, and all queued jobs have been drained
+                return;
+            }
+            job = std::move(pool->jobs.front());
+            pool->jobs.pop_front();
+        }
+        job();
+    }
+}
+
+WorkerPool* worker_pool_create(uint32_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    WorkerPool* pool = new WorkerPool{};
+    pool->threads.reserve(thread_count);
+    for (uint32_t i = 0; i < thread_count; i++) {
+        pool->threads.emplace_back(worker_loop, pool);
+    }
+
+    return pool;
+}
+
+void worker_pool_destroy(WorkerPool* pool) {
+    {
+        std::lock_guard lock(pool->mutex);
+        pool->stopping = true;
+    }
+    pool->job_available.notify_all();
+
+    for (std::thread& thread : pool->threads) {
+        thread.join();
+    }
+
+    delete pool;
+}
+
+uint32_t worker_pool_thread_count(const WorkerPool* pool) { return static_cast<uint32_t>(pool->threads.size()); }
+
+std::future<void> worker_pool_submit(WorkerPool* pool, std::function<void()>&& job) {
+    // std::function must be copyable, so the move-only packaged task lives behind a shared pointer
+    auto              task   = std::make_shared<std::packaged_task<void()>>(std::move(job));
+    std::future<void> future = task->get_future();
+    {
+        std::lock_guard lock(pool->mutex);
+        pool->jobs.emplace_back([task] { (*task)(); });
+    }
+    pool->job_available.notify_one();
+
+    return future;
+}
+
+} // namespace vk_gltf
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vk_gltf {
+
+// fixed size pool of threads that run jobs in submission order. jobs must not block on other jobs submitted to the same pool
+struct WorkerPool {
+    std::vector<std::thread>          threads{};
+    std::deque<std::function<void()>> jobs{};
+    std::mutex                        mutex{};
+    std::condition_variable           job_available{};
+    bool                              stopping{false};
+};
+
+// thread_count of 0 uses std::thread::hardware_concurrency()
+[[nodiscard]] WorkerPool* worker_pool_create(uint32_t thread_count);
+
+void worker_pool_destroy(WorkerPool* pool);
+
+[[nodiscard]] uint32_t worker_pool_thread_count(const WorkerPool* pool);
+
+[[nodiscard]] std::future<void> worker_pool_submit(WorkerPool* pool, std::function<void()>&& job);
+
+} // namespace vk_gltf
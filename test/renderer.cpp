@@ -440,9 +440,9 @@ void renderer_add_gltf_asset(Renderer* renderer, const char* gltf_path) {
     gltf_load_options.gltf_path      = gltf_path;
     gltf_load_options.cache_dir      = "cache/";
     gltf_load_options.create_mipmaps = true;
+    gltf_load_options.pack_geometry  = true;
 
-    vk_gltf::GltfAsset asset = load_gltf(&gltf_load_options, renderer->allocator, renderer->vk_context.device,
-                                         renderer->vk_context.frame_command_pool, renderer->vk_context.graphics_queue);
+    vk_gltf::GltfAsset asset = load_gltf(&gltf_load_options, &renderer->loader_context);
 
     // add new draw objects
     for (const vk_gltf::GltfNode& node : asset.nodes) {
@@ -465,23 +465,34 @@ void renderer_add_gltf_asset(Renderer* renderer, const char* gltf_path) {
                 new_draw_object.front_face = VK_FRONT_FACE_CLOCKWISE;
             }
 
-            if (gltf_primitive.index_buffer.has_value()) {
-                const vk_gltf::GltfBuffer* gltf_buf = &gltf_primitive.index_buffer.value();
-                AllocatedBuffer            index_buf{};
-                index_buf.address         = gltf_buf->address;
-                index_buf.buffer          = gltf_buf->buffer;
-                index_buf.allocation      = gltf_buf->allocation;
-                index_buf.allocation_info = gltf_buf->allocation_info;
+            // packed primitives draw out of their geometry arena, which holds both their indices and vertices
+            const vk_gltf::GltfBuffer* gltf_index_buf  = nullptr;
+            const vk_gltf::GltfBuffer* gltf_vertex_buf = &gltf_primitive.vertex_buffer;
+            if (gltf_primitive.geometry_arena.has_value()) {
+                gltf_index_buf  = &renderer->loader_context.geometry_arenas[gltf_primitive.geometry_arena.value()].buffer;
+                gltf_vertex_buf = gltf_index_buf;
+            } else if (gltf_primitive.index_buffer.has_value()) {
+                gltf_index_buf = &gltf_primitive.index_buffer.value();
+            }
+
+            if (gltf_index_buf != nullptr && gltf_primitive.index_count > 0) {
+                AllocatedBuffer index_buf{};
+                index_buf.address         = gltf_index_buf->address;
+                index_buf.buffer          = gltf_index_buf->buffer;
+                index_buf.allocation      = gltf_index_buf->allocation;
+                index_buf.allocation_info = gltf_index_buf->allocation_info;
 
                 new_draw_object.index_buffer = index_buf;
             } else {
                 abort_message("currently not handling GLTF assets without index buffers");
             }
 
-            new_draw_object.index_count = gltf_primitive.index_count;
-            new_draw_object.index_type  = gltf_primitive.index_type;
+            new_draw_object.index_count   = gltf_primitive.index_count;
+            new_draw_object.index_type    = gltf_primitive.index_type;
+            new_draw_object.first_index   = gltf_primitive.first_index;
+            new_draw_object.vertex_offset = gltf_primitive.vertex_offset;
 
-            const vk_gltf::GltfBuffer* gltf_buf = &gltf_primitive.vertex_buffer;
+            const vk_gltf::GltfBuffer* gltf_buf = gltf_vertex_buf;
 
             AllocatedBuffer vertex_buf{};
             vertex_buf.address         = gltf_buf->address;
@@ -594,7 +605,8 @@ void renderer_add_gltf_asset(Renderer* renderer, const char* gltf_path) {
         }
 
         if (gltf_texture.sampler_index.has_value()) {
-            new_texture.sampler = asset.samplers[gltf_texture.sampler_index.value()];
+            const uint32_t sampler_index = asset.samplers[gltf_texture.sampler_index.value()];
+            new_texture.sampler          = renderer->loader_context.samplers[sampler_index].sampler;
         } else {
             new_texture.sampler = renderer->default_sampler;
         }
@@ -784,7 +796,8 @@ void renderer_draw(Renderer* renderer) {
     vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->opaque_graphics_pipeline.pipeline_layout, 0, desc_sets.size(),
                             desc_sets.data(), 0, nullptr);
 
-    glm::mat4 camera_view_proj = global::camera.proj * camera_view();
+    glm::mat4 camera_view_proj   = global::camera.proj * camera_view();
+    VkBuffer  bound_index_buffer = VK_NULL_HANDLE;
     for (const DrawObject& opaque_draw : renderer->opaque_draws) {
         if (!is_visible(&opaque_draw, camera_view_proj)) {
             continue;
@@ -801,8 +814,12 @@ void renderer_draw(Renderer* renderer) {
         vkCmdPushConstants(command_buffer, renderer->opaque_graphics_pipeline.pipeline_layout, VK_SHADER_STAGE_ALL, 0, sizeof(PushConstants),
                            &push_constants);
 
-        vkCmdBindIndexBuffer(command_buffer, opaque_draw.index_buffer.buffer, 0, opaque_draw.index_type);
-        vkCmdDrawIndexed(command_buffer, opaque_draw.index_count, 1, 0, 0, 0);
+        // draws packed into the same geometry arena share one index buffer binding
+        if (opaque_draw.index_buffer.buffer != bound_index_buffer) {
+            vkCmdBindIndexBuffer(command_buffer, opaque_draw.index_buffer.buffer, 0, opaque_draw.index_type);
+            bound_index_buffer = opaque_draw.index_buffer.buffer;
+        }
+        vkCmdDrawIndexed(command_buffer, opaque_draw.index_count, 1, opaque_draw.first_index, opaque_draw.vertex_offset, 0);
     }
 
     vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->transparent_graphics_pipeline.pipeline);
@@ -820,8 +837,12 @@ void renderer_draw(Renderer* renderer) {
         vkCmdPushConstants(command_buffer, renderer->transparent_graphics_pipeline.pipeline_layout, VK_SHADER_STAGE_ALL, 0, sizeof(PushConstants),
                            &push_constants);
 
-        vkCmdBindIndexBuffer(command_buffer, transparent_draw.index_buffer.buffer, 0, transparent_draw.index_type);
-        vkCmdDrawIndexed(command_buffer, transparent_draw.index_count, 1, 0, 0, 0);
+        // draws packed into the same geometry arena share one index buffer binding
+        if (transparent_draw.index_buffer.buffer != bound_index_buffer) {
+            vkCmdBindIndexBuffer(command_buffer, transparent_draw.index_buffer.buffer, 0, transparent_draw.index_type);
+            bound_index_buffer = transparent_draw.index_buffer.buffer;
+        }
+        vkCmdDrawIndexed(command_buffer, transparent_draw.index_count, 1, transparent_draw.first_index, transparent_draw.vertex_offset, 0);
     }
 
     vkCmdEndRenderingKHR(command_buffer);
@@ -909,6 +930,9 @@ void renderer_create(Renderer* renderer) {
 
     renderer->allocator = allocator_create(&renderer->vk_context);
 
+    renderer->loader_context =
+        vk_gltf::loader_context_create(renderer->allocator, vk_ctx->device, vk_ctx->frame_command_pool, vk_ctx->graphics_queue);
+
     create_render_resources(renderer);
 
     renderer->frames = frames_create(vk_ctx->device, vk_ctx->frame_command_pool, swapchain_ctx->image_views, swapchain_ctx->images,
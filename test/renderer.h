@@ -66,6 +66,8 @@ struct DrawObject {
     AllocatedBuffer     index_buffer{};
     VkIndexType         index_type{};
     uint32_t            index_count{};
+    uint32_t            first_index{};
+    int32_t             vertex_offset{};
     AllocatedBuffer     vertex_buffer{};
     Bounds              bounds{};
     VkFrontFace         front_face{};
@@ -84,6 +86,7 @@ struct Renderer {
     GraphicsPipeline             opaque_graphics_pipeline{};
     GraphicsPipeline             transparent_graphics_pipeline{};
     VmaAllocator                 allocator{};
+    vk_gltf::LoaderContext       loader_context{};
     AllocatedImage               msaa_color_image{};
     AllocatedImage               depth_image{};
     VkDescriptorPool             descriptor_pool{};
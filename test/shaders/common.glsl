@@ -57,6 +57,82 @@ layout (scalar, buffer_reference) readonly buffer VertexBuffer {
     Vertex vertices[];
 };
 
+// vk_gltf::PackedVertex. normal and tangent are octahedral snorm16x2, with the tangent's w sign in bit 16. color is unorm8x4
+struct PackedVertex {
+    vec3 position;
+    uint normal;
+    uint tangent;
+    uint color;
+    uint tex_coords[2];
+};
+
+// vk_gltf::QuantizedVertex. position is unorm16x3 across the primitive's bounds, followed by 16 bits of padding
+struct QuantizedVertex {
+    uint position[2];
+    uint normal;
+    uint tangent;
+    uint color;
+    uint tex_coords[2];
+};
+
+layout (scalar, buffer_reference) readonly buffer PackedVertexBuffer {
+    PackedVertex vertices[];
+};
+
+layout (scalar, buffer_reference) readonly buffer QuantizedVertexBuffer {
+    QuantizedVertex vertices[];
+};
+
+// position streams of vk_gltf::GltfPrimitive::position_address, indexed with gl_VertexIndex like the vertex buffers
+layout (scalar, buffer_reference) readonly buffer PositionBuffer {
+    vec3 positions[];
+};
+
+layout (scalar, buffer_reference) readonly buffer QuantizedPositionBuffer {
+    uvec2 positions[];
+};
+
+vec3 decode_octahedral(uint bits) {
+    vec2 e = unpackSnorm2x16(bits);
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-v.z, 0.0);
+    v.x += v.x >= 0.0 ? -t : t;
+    v.y += v.y >= 0.0 ? -t : t;
+    return normalize(v);
+}
+
+vec4 decode_tangent(uint bits) {
+    return vec4(decode_octahedral(bits), (bits & 0x10000u) != 0u ? -1.0 : 1.0);
+}
+
+Vertex decode_packed_vertex(PackedVertex p) {
+    Vertex v;
+    v.position = p.position;
+    v.normal = decode_octahedral(p.normal);
+    v.tangent = decode_tangent(p.tangent);
+    v.color = unpackUnorm4x8(p.color);
+    v.tex_coords[0] = unpackHalf2x16(p.tex_coords[0]);
+    v.tex_coords[1] = unpackHalf2x16(p.tex_coords[1]);
+    return v;
+}
+
+// bounds_origin and bounds_extent are the primitive's vk_gltf::Bounds
+vec3 decode_quantized_position(uvec2 bits, vec3 bounds_origin, vec3 bounds_extent) {
+    vec3 normalized = vec3(unpackUnorm2x16(bits.x), unpackUnorm2x16(bits.y).x);
+    return bounds_origin + (normalized * 2.0 - 1.0) * bounds_extent;
+}
+
+Vertex decode_quantized_vertex(QuantizedVertex q, vec3 bounds_origin, vec3 bounds_extent) {
+    Vertex v;
+    v.position = decode_quantized_position(uvec2(q.position[0], q.position[1]), bounds_origin, bounds_extent);
+    v.normal = decode_octahedral(q.normal);
+    v.tangent = decode_tangent(q.tangent);
+    v.color = unpackUnorm4x8(q.color);
+    v.tex_coords[0] = unpackHalf2x16(q.tex_coords[0]);
+    v.tex_coords[1] = unpackHalf2x16(q.tex_coords[1]);
+    return v;
+}
+
 layout (push_constant) uniform PushConstants {
     mat4 model_transform;
     VertexBuffer vertex_buffer;
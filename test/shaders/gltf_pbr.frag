@@ -108,21 +108,27 @@ float convert_EV100_to_exposure(float EV100) {
     return 1.f / max_luminance;
 }
 
+// normal maps may be stored with only x and y, so z is always rebuilt from them
+vec3 unpack_tex_normal(vec2 tex_normal_xy) {
+    vec2 xy = tex_normal_xy * 2.f - 1.f;
+    return vec3(xy, sqrt(max(1.f - dot(xy, xy), 0.f)));
+}
+
 void main() {
     Material mat = material_buf.materials[nonuniformEXT (constants.material_index)];
 
-    vec3 tex_normal = texture(tex_samplers[nonuniformEXT (mat.normal_texture.index)], normal_uv).xyz;
+    vec2 tex_normal_xy = texture(tex_samplers[nonuniformEXT (mat.normal_texture.index)], normal_uv).xy;
     vec4 tex_color = texture(tex_samplers[nonuniformEXT (mat.base_color_texture.index)], color_uv).rgba;
 
     float mipmap_level = (textureQueryLOD(tex_samplers[nonuniformEXT (mat.base_color_texture.index)], color_uv).x);
 
     vec3 normal = vert_normal;
 
-    // until i can find a branchless option, simply don't apply normal mapping if the tex_normal == vec(1)
+    // until i can find a branchless option, simply don't apply normal mapping if the tex_normal_xy == vec(1)
     // since this means we read the default texture. aka, there is no normal map.
     mat3 TBN;
-    if (tex_normal != vec3(1)){
-        tex_normal = tex_normal* 2.f - 1.f;
+    if (tex_normal_xy != vec2(1)){
+        vec3 tex_normal = unpack_tex_normal(tex_normal_xy);
         tex_normal *= vec3(mat.normal_scale, mat.normal_scale, 1);
         tex_normal = normalize(tex_normal);
         vec3 bitangent = cross(vert_normal, vec3(vert_tangent)) * -vert_tangent.w;
@@ -169,11 +175,10 @@ void main() {
 
         float clearcoat_roughness = texture(tex_samplers[nonuniformEXT (mat.clearcoat_roughness_texture.index)], clearcoat_rough_uv).g * mat.clearcoat_roughness_factor;
         vec3 clearcoat_normal  = normal;
-        vec3 tex_clearcoat_normal = texture(tex_samplers[nonuniformEXT (mat.clearcoat_normal_texture.index)], clearcoat_normal_uv).xyz;
+        vec2 tex_clearcoat_normal_xy = texture(tex_samplers[nonuniformEXT (mat.clearcoat_normal_texture.index)], clearcoat_normal_uv).xy;
         // only apply bump mapping if clearcoat normal isn't the default texture
-        if (tex_clearcoat_normal != vec3(1)){
-            tex_clearcoat_normal = tex_clearcoat_normal * 2.f - 1.f;
-            tex_clearcoat_normal = normalize(TBN * tex_clearcoat_normal);
+        if (tex_clearcoat_normal_xy != vec2(1)){
+            clearcoat_normal = normalize(TBN * unpack_tex_normal(tex_clearcoat_normal_xy));
         }
 
         float clearcoat_brdf = specular_brdf(clearcoat_normal, halfway_dir, light_dir, view_dir, roughness);